@@ -0,0 +1,48 @@
+(in-package :maxima)
+
+;; Connecting Maxima to wxMaxima over a unix domain socket.
+;;
+;; wxMaxima preloads this file and starts Maxima with
+;;   -r ":lisp (wx-setup-client PORT)"
+;; The path of the socket is in the environment variable
+;; WXMAXIMA_SOCKET. Lisps without unix domain sockets, or a socket
+;; which can not be opened, fall back to setup-client on the tcp PORT.
+
+;; ECL has the sb-bsd-sockets package in its sockets module
+(eval-when (:compile-toplevel :load-toplevel :execute)
+  #+sbcl (ignore-errors (require :sb-bsd-sockets))
+  #+ecl (ignore-errors (require :sockets)))
+
+(defun wx-open-local-socket (path)
+  (declare (ignorable path))
+  (ignore-errors
+    #+(or sbcl ecl)
+    (when (find-package :sb-bsd-sockets)
+      (let ((socket (make-instance (find-symbol "LOCAL-SOCKET" :sb-bsd-sockets)
+                                   :type :stream)))
+        (funcall (find-symbol "SOCKET-CONNECT" :sb-bsd-sockets) socket path)
+        (funcall (find-symbol "SOCKET-MAKE-STREAM" :sb-bsd-sockets) socket
+                 :input t :output t :buffering :full
+                 :external-format :utf-8)))
+    #+ccl
+    (ccl:make-socket :address-family :file :remote-filename path
+                     :external-format :utf-8)
+    #-(or sbcl ecl ccl)
+    nil))
+
+(defun wx-setup-client (port)
+  (let* ((path (maxima-getenv "WXMAXIMA_SOCKET"))
+         (sock (and path (> (length path) 0) (wx-open-local-socket path))))
+    (if (null sock)
+        (setup-client port)
+        (progn
+          (setq *socket-connection* sock)
+          (setq *standard-input* sock)
+          (setq *standard-output* sock)
+          (setq *error-output* sock)
+          (setq *terminal-io* sock)
+          (setq *trace-output* sock)
+          (format t "pid=~a~%" (getpid))
+          (force-output sock)
+          (setq *debug-io* sock)
+          (values)))))
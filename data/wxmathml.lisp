@@ -80,6 +80,20 @@
 
 (defvar *var-tag* '("<v>" "</v>"))
 
+;; t while mydispla builds the compact display encoding (see
+;; wx-compact-display). The atoms are then emitted as finished elements
+;; of the encoding instead of as xml.
+(defvar *wx-compact-output* nil)
+
+(defstruct (wx-compact-element (:constructor make-wx-compact-element (encoding)))
+  encoding)
+
+;; The element <tag>text</tag>, text is already escaped.
+(defun wxxml-leaf (tag text)
+  (if *wx-compact-output*
+      (make-wx-compact-element (format nil "(~a ~d:~a)" tag (length text) text))
+      (concatenate 'string "<" tag ">" text "</" tag ">")))
+
 (defun wxxml-get (x p)
   (if (symbolp x) (get x p)))
 
@@ -143,31 +157,31 @@
 		       (setq tmp-x (wxxml-fix-string x))
 		       (if (and (boundp '$stringdisp) $stringdisp)
 			   (setq tmp-x (format nil "\"~a\"" tmp-x)))
-		       (concatenate 'string "<st>" tmp-x "</st>"))
+		       (wxxml-leaf "st" tmp-x))
 		      ((arrayp x)
-		       (format nil "<v>Lisp array [~{~a~^,~}]</v>"
-			       (array-dimensions x)))
+		       (wxxml-leaf "v" (format nil "Lisp array [~{~a~^,~}]"
+					       (array-dimensions x))))
 		      ((streamp x)
-		       (format nil "<v>Stream [~A]</v>"
-			       (stream-element-type x)))
+		       (wxxml-leaf "v" (format nil "Stream [~A]"
+					       (stream-element-type x))))
 		      ((member (type-of x) '(GRAPH DIGRAPH))
-		       (format nil "<v>~a</v>" x))
+		       (wxxml-leaf "v" (format nil "~a" x)))
                       ((typep x 'structure-object)
-		       (format nil "<v>Structure [~A]</v>" (type-of x)))
+		       (wxxml-leaf "v" (format nil "Structure [~A]" (type-of x))))
 		      ((hash-table-p x)
-		       (format nil "<v>HashTable</v>"))
+		       (wxxml-leaf "v" "HashTable"))
                       (t (wxxml-stripdollar x))))
 	  r))
 
 (defun wxxmlnumformat (atom)
   (let (r firstpart exponent)
     (cond ((integerp atom)
-           (format nil "<n>~{~c~}</n>" (exploden atom)))
+           (wxxml-leaf "n" (format nil "~{~c~}" (exploden atom))))
 	  (t
 	   (setq r (exploden atom))
 	   (setq exponent (member 'e r :test #'string-equal))
 	   (cond ((null exponent)
-		  (format nil "<n>~{~c~}</n>" r))
+		  (wxxml-leaf "n" (format nil "~{~c~}" r)))
 		 (t
 		  (setq firstpart
 			(nreverse (cdr (member 'e (reverse r)
@@ -175,9 +189,14 @@
 		  (if (char= (cadr exponent) #\+)
 		      (setq exponent (cddr exponent))
 		      (setq exponent (cdr exponent)))
-		  (format nil
-			  "<r><n>~{~c~}</n><h>*</h><e><n>10</n><n>~{~c~}</n></e></r>"
-			  firstpart exponent)))))))
+		  (if *wx-compact-output*
+		      (make-wx-compact-element
+		       (format nil "(r (n ~d:~{~c~})(h 1:*)(e (n 2:10)(n ~d:~{~c~})))"
+			       (length firstpart) firstpart
+			       (length exponent) exponent))
+		      (format nil
+			      "<r><n>~{~c~}</n><h>*</h><e><n>10</n><n>~{~c~}</n></e></r>"
+			      firstpart exponent))))))))
 
 (defun wxxml-stripdollar (sym &aux pname)
   (or (symbolp sym)
@@ -197,7 +216,9 @@
 		     (concatenate 'string "?" pname))
 		    (t pname)))
   (setq pname (wxxml-fix-string pname))
-  (concatenate 'string (car *var-tag*) pname (cadr *var-tag*)))
+  (if *wx-compact-output*
+      (wxxml-leaf (string-trim "<>" (car *var-tag*)) pname)
+      (concatenate 'string (car *var-tag*) pname (cadr *var-tag*))))
 
 (defun wxxml-paren (x l r)
   (wxxml x (append l '("<p>")) (cons "</p>" r) 'mparen 'mparen))
@@ -305,7 +326,7 @@
 (defun wxxml-dissym-to-string (lst &aux pname)
   (setq pname
 	(wxxml-fix-string (format nil "~{~a~}" lst)))
-  (concatenate 'string "<v>" pname "</v>"))
+  (wxxml-leaf "v" pname))
 
 (defun wxxmlsym (x)
   (or (get x 'wxxmlsym)
@@ -1039,11 +1060,112 @@
 
 (defprop spaceout wxxml-spaceout wxxml)
 
+;; Compact display encoding, enabled by wxMaxima with (wx-compact-display t).
+;; The xml tree is written in prefix form with length prefixed text:
+;;   element    (name @attribute=LENGTH:value ... children)
+;;   text       LENGTH:characters
+;; and the result is sent as <wxb LENGTH> followed by LENGTH characters.
+;; Text keeps the xml escapes, so the encoding never contains #\<.
+;;
+;; The atoms, which hold all text of a result that is not constant, are
+;; emitted in this encoding by wxxml itself (see wxxml-leaf). The rest of
+;; the list wxxml builds is constant markup like "<r>", "</p></fn>" or
+;; "<t>+</t>" from this file, whose encoding is looked up.
+
+(defvar *wx-compact-display* nil)
+
+;; Lengths are counted in characters, which wxMaxima can only match when
+;; the lisp has unicode strings.
+(defun wx-compact-display (on)
+  (setq *wx-compact-display* (and on (> char-code-limit 256))))
+
+(defun wx-compact-text (text out)
+  (format out "~d:~a" (length text) text))
+
+(defun wx-compact-attributes (tag out)
+  (do ((start (position #\" tag) (position #\" tag :start (1+ end)))
+       (name-start 0 (1+ end))
+       (end))
+      ((null start))
+    (setq end (position #\" tag :start (1+ start)))
+    (format out "@~a=" (string-trim " " (subseq tag name-start (1- start))))
+    (wx-compact-text (subseq tag (1+ start) end) out)))
+
+;; Writes the encoding of the xml text in xml to out.
+(defun wx-compact-encode (xml out)
+  (do ((i 0) (n (length xml)))
+      ((>= i n))
+    (if (char= (char xml i) #\<)
+        (let* ((end (position #\> xml :start i))
+               (tag (subseq xml (1+ i) end))
+               (empty (char= (char tag (1- (length tag))) #\/)))
+          (setq i (1+ end))
+          (cond ((char= (char tag 0) #\/)
+                 (write-char #\) out))
+                (t
+                 (if empty
+                     (setq tag (subseq tag 0 (1- (length tag)))))
+                 (let ((space (position #\Space tag)))
+                   (format out "(~a " (subseq tag 0 space))
+                   (if space
+                       (wx-compact-attributes (subseq tag space) out)))
+                 (if empty
+                     (write-char #\) out)))))
+        (let ((end (or (position #\< xml :start i) n)))
+          (wx-compact-text (subseq xml i end) out)
+          (setq i end)))))
+
+;; A markup fragment starts and ends with a tag and encodes on its own.
+;; Those are string constants, so their encoding is remembered by
+;; identity. Only text between fragments, like the digits of bigfloats,
+;; is joined and encoded.
+(defvar *wx-compact-fragments* (make-hash-table :test #'eq))
+
+(defun wx-compact-markup-p (fragment)
+  (and (stringp fragment)
+       (> (length fragment) 1)
+       (char= (char fragment 0) #\<)
+       (char= (char fragment (1- (length fragment))) #\>)))
+
+(defun wx-compact-fragment (fragment)
+  (or (gethash fragment *wx-compact-fragments*)
+      (progn
+        ;; labels and a few other fragments are built for each result
+        (if (> (hash-table-count *wx-compact-fragments*) 4096)
+            (clrhash *wx-compact-fragments*))
+        (setf (gethash fragment *wx-compact-fragments*)
+              (with-output-to-string (out)
+                (wx-compact-encode fragment out))))))
+
+(defun wx-compact-encode-list (xml)
+  (with-output-to-string (out)
+    (let ((run nil))
+      (flet ((flush ()
+               (when run
+                 (wx-compact-encode (format nil "~{~a~}" (nreverse run)) out)
+                 (setq run nil))))
+        (dolist (fragment xml)
+          (cond ((wx-compact-element-p fragment)
+                 (flush)
+                 (write-string (wx-compact-element-encoding fragment) out))
+                ((wx-compact-markup-p fragment)
+                 (flush)
+                 (write-string (wx-compact-fragment fragment) out))
+                (t
+                 (push fragment run))))
+        (flush)))))
+
 (defun mydispla (x)
-  (let ((*print-circle* nil)
-        (*wxxml-mratp* (format nil "~{~a~}" (cdr (checkrat x)))))
-    (mapc #'princ
-          (wxxml x '("<mth>") '("</mth>") 'mparen 'mparen))))
+  (let* ((*print-circle* nil)
+         (*wxxml-mratp* (format nil "~{~a~}" (cdr (checkrat x))))
+         (compact (and *wx-compact-display*
+                       (ignore-errors
+                         (let ((*wx-compact-output* t))
+                           (wx-compact-encode-list
+                            (wxxml x '("<mth>") '("</mth>") 'mparen 'mparen)))))))
+    (if compact
+        (format t "<wxb ~d>~a" (length compact) compact)
+        (mapc #'princ (wxxml x '("<mth>") '("</mth>") 'mparen 'mparen)))))
 
 (setf *alt-display2d* 'mydispla)
 
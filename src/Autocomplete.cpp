@@ -111,21 +111,43 @@ bool AutoComplete::LoadSymbols(wxString file)
   }
 
   m_symbolList.Sort();
+  IndexSymbols();
 
   return false;
 }
 
+/// Rebuild the sets used to check for duplicates in AddSymbol.
+void AutoComplete::IndexSymbols()
+{
+  m_symbols.clear();
+  for (size_t i = 0; i < m_symbolList.GetCount(); i++)
+    m_symbols.insert(m_symbolList[i]);
+
+  m_templateKeys.clear();
+  for (size_t i = 0; i < m_templateList.GetCount(); i++)
+    m_templateKeys.insert(TemplateKey(m_templateList[i]));
+}
+
+/// Templates with the same function name and number of arguments get the
+/// same key.
+wxString AutoComplete::TemplateKey(wxString templ)
+{
+  return templ.SubString(0, templ.Find(wxT("("))) +
+         wxString::Format(wxT("%d"), templ.Freq('<'));
+}
+
 /// Returns a string array with functions which start with partial.
 wxArrayString AutoComplete::CompleteSymbol(wxString partial, bool templates)
 {
   wxArrayString completions;
   wxArrayString perfectCompletions;
+  SymbolSet found, perfectFound;
 
   if (!templates) {
     for (int i=0; i<m_symbolList.GetCount(); i++)
     {
       if (m_symbolList[i].StartsWith(partial) &&
-          completions.Index(m_symbolList[i]) == wxNOT_FOUND)
+          found.insert(m_symbolList[i]).second)
         completions.Add(m_symbolList[i]);
     }
   }
@@ -136,10 +158,10 @@ wxArrayString AutoComplete::CompleteSymbol(wxString partial, bool templates)
       wxString templ = m_templateList[i];
       if (templ.StartsWith(partial))
       {
-        if (completions.Index(templ) == wxNOT_FOUND)
+        if (found.insert(templ).second)
           completions.Add(templ);
         if (templ.SubString(0, templ.Find(wxT("(")) - 1) == partial &&
-            perfectCompletions.Index(templ) == wxNOT_FOUND)
+            perfectFound.insert(templ).second)
           perfectCompletions.Add(templ);
       }
     }
@@ -165,7 +187,7 @@ void AutoComplete::AddSymbol(wxString fun, bool templ)
   }
 
   /// Add symbols
-  if (!templ && m_symbolList.Index(fun, true, true) == wxNOT_FOUND)
+  if (!templ && m_symbols.insert(fun).second)
     m_symbolList.Add(fun);
 
   /// Add templates - for given function and given argument count we
@@ -173,15 +195,7 @@ void AutoComplete::AddSymbol(wxString fun, bool templ)
   if (templ)
   {
     fun = FixTemplate(fun);
-    wxString funName = fun.SubString(0, fun.Find(wxT("(")));
-    int count = fun.Freq('<'), i=0;
-    for (i=0; i<m_templateList.GetCount(); i++)
-    {
-      wxString t = m_templateList[i];
-      if (t.StartsWith(funName) && t.Freq('<') == count)
-        break;
-    }
-    if (i == m_templateList.GetCount())
+    if (m_templateKeys.insert(TemplateKey(fun)).second)
       m_templateList.Add(fun);
   }
 }
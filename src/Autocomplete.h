@@ -23,6 +23,9 @@
 #include <wx/wx.h>
 #include <wx/arrstr.h>
 #include <wx/regex.h>
+#include <wx/hashset.h>
+
+WX_DECLARE_HASH_SET(wxString, wxStringHash, wxStringEqual, SymbolSet);
 
 class AutoComplete
 {
@@ -33,8 +36,12 @@ public:
   wxArrayString CompleteSymbol(wxString partial, bool templates = false);
   wxString FixTemplate(wxString templ);
 private:
+  wxString TemplateKey(wxString templ);
+  void IndexSymbols();
   wxArrayString m_symbolList;
   wxArrayString m_templateList;
+  SymbolSet m_symbols;       // the entries of m_symbolList
+  SymbolSet m_templateKeys;  // TemplateKey of the entries of m_templateList
   wxRegEx m_args;
 };
 
@@ -0,0 +1,281 @@
+///
+///  Copyright (C) 2004-2011 Andrej Vodopivec <andrej.vodopivec@gmail.com>
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///
+///  You should have received a copy of the GNU General Public License
+///  along with this program; if not, write to the Free Software
+///  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+///
+
+
+#include "BatchRunner.h"
+#include "wxMaxima.h"
+
+#include <wx/dir.h>
+#include <wx/filename.h>
+#include <wx/stdpaths.h>
+#include <wx/textfile.h>
+
+#if !defined __WXMSW__
+#include <sys/resource.h>
+#endif
+
+#define BATCH_DRAIN_INTERVAL 100 // ms between reading the workers' output
+#define BATCH_READ_SIZE 4096
+
+enum {
+  batch_timer_id
+};
+
+BatchRunner::BatchRunner(const wxArrayString& files, int workers)
+{
+  for (size_t i = 0; i < files.GetCount(); i++) {
+    BatchJob job;
+    job.file = files[i];
+    m_jobs.push_back(job);
+  }
+
+  if (workers < 1)
+    workers = 1;
+  m_processes.resize(workers, NULL);
+  m_workerJobs.resize(workers, 0);
+  m_workerTimes.resize(workers);
+  m_outputDecoders.resize(workers);
+  m_errorDecoders.resize(workers);
+
+  m_next = 0;
+  m_running = 0;
+
+  m_timer.SetOwner(this, batch_timer_id);
+}
+
+BatchRunner::~BatchRunner()
+{
+  for (size_t i = 0; i < m_processes.size(); i++)
+    if (m_processes[i] != NULL)
+      m_processes[i]->Detach();
+}
+
+/***
+ * Expand directories in args to the .wxm and .wxmx files they contain.
+ * A .wxm whose .wxmx is also listed is skipped, both would be saved to
+ * the same .wxmx.
+ */
+void BatchRunner::CollectFiles(const wxArrayString& args, wxArrayString& files)
+{
+  wxArrayString all;
+  for (size_t i = 0; i < args.GetCount(); i++) {
+    if (wxDirExists(args[i])) {
+      wxArrayString found;
+      wxDir::GetAllFiles(args[i], &found, wxT("*.wxm"));
+      wxDir::GetAllFiles(args[i], &found, wxT("*.wxmx"));
+      found.Sort();
+      WX_APPEND_ARRAY(all, found);
+    }
+    else
+      all.Add(args[i]);
+  }
+
+  for (size_t i = 0; i < all.GetCount(); i++)
+    if (all[i].Right(4) != wxT(".wxm") || all.Index(all[i] + wxT("x")) == wxNOT_FOUND)
+      files.Add(all[i]);
+}
+
+/***
+ * Peak memory of this process and of the Maxima with maximaPid, in kB.
+ * Maxima's is only known on Linux.
+ */
+long BatchRunner::PeakMemory(long maximaPid)
+{
+#if defined __WXMSW__
+  return -1;
+#else
+  long peak = 0;
+
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) == 0)
+#if defined __WXMAC__
+    peak += usage.ru_maxrss / 1024; // bytes on Mac OS X
+#else
+    peak += usage.ru_maxrss;
+#endif
+
+  wxString status = wxString::Format(wxT("/proc/%ld/status"), maximaPid);
+  wxTextFile file;
+  if (maximaPid > 0 && wxFileExists(status) && file.Open(status)) {
+    for (wxString line = file.GetFirstLine(); !file.Eof(); line = file.GetNextLine()) {
+      long hwm;
+      if (line.StartsWith(wxT("VmHWM:"), &line) && line.Trim(false).BeforeFirst(wxT(' ')).ToLong(&hwm))
+        peak += hwm;
+    }
+  }
+
+  return peak;
+#endif
+}
+
+/***
+ * Start the runner, the workers start from the timer once the event loop
+ * runs.
+ */
+void BatchRunner::Start()
+{
+  wxPrintf(wxT("%-8s %10s %12s  %s\n"), wxT("status"), wxT("time[s]"), wxT("peak[kB]"), wxT("document"));
+  fflush(stdout);
+
+  m_stopwatch.Start();
+  m_timer.Start(BATCH_DRAIN_INTERVAL);
+}
+
+void BatchRunner::StartNext(size_t worker)
+{
+  if (m_next >= m_jobs.size())
+    return;
+
+  size_t job = m_next++;
+  wxString program = wxStandardPaths::Get().GetExecutablePath();
+#if defined __WXMSW__
+  wxString command = wxT("\"") + program + wxT("\" -b -o \"") + m_jobs[job].file + wxT("\"");
+#else
+  wxString command = wxT("\"") + program + wxT("\" --batch \"") + m_jobs[job].file + wxT("\"");
+#endif
+
+  wxProcess *process = new wxProcess(this, wxID_ANY);
+  process->Redirect();
+  m_workerTimes[worker].Start();
+
+  if (wxExecute(command, wxEXEC_ASYNC, process) <= 0) {
+    delete process;
+    m_jobs[job].exitCode = 2;
+    m_jobs[job].output = wxT("could not start ") + command;
+    return;
+  }
+
+  m_processes[worker] = process;
+  m_workerJobs[worker] = job;
+  m_outputDecoders[worker].Reset();
+  m_errorDecoders[worker].Reset();
+  m_running++;
+}
+
+/***
+ * Read what the worker wrote so far, so that it does not block on a
+ * full pipe.
+ */
+void BatchRunner::Drain(size_t worker)
+{
+  wxProcess *process = m_processes[worker];
+  BatchJob& job = m_jobs[m_workerJobs[worker]];
+
+  if (process->IsInputAvailable())
+    Drain(process->GetInputStream(), m_outputDecoders[worker], job.output);
+  if (process->IsErrorAvailable())
+    Drain(process->GetErrorStream(), m_errorDecoders[worker], job.output);
+}
+
+/***
+ * Read what one pipe of a worker has now in blocks, the workers write
+ * UTF-8.
+ */
+void BatchRunner::Drain(wxInputStream *stream, Utf8Decoder& decoder, wxString& output)
+{
+  if (stream == NULL)
+    return;
+
+  char buffer[BATCH_READ_SIZE];
+  // Read returns what is there once it has some bytes
+  while (stream->CanRead())
+  {
+    stream->Read(buffer, BATCH_READ_SIZE);
+    size_t read = stream->LastRead();
+    if (read == 0)
+      break;
+    decoder.Decode(buffer, read, output);
+  }
+}
+
+/***
+ * Read the output of the running workers and start the next documents
+ * on idle ones.
+ */
+void BatchRunner::OnTimer(wxTimerEvent& event)
+{
+  for (size_t i = 0; i < m_processes.size(); i++) {
+    if (m_processes[i] != NULL)
+      Drain(i);
+    else
+      StartNext(i);
+  }
+
+  if (m_running == 0 && m_next >= m_jobs.size())
+    Finish();
+}
+
+void BatchRunner::OnProcessEvent(wxProcessEvent& event)
+{
+  size_t worker = 0;
+  while (worker < m_processes.size() &&
+         (m_processes[worker] == NULL || m_processes[worker]->GetPid() != event.GetPid()))
+    worker++;
+  if (worker == m_processes.size())
+    return;
+
+  Drain(worker);
+
+  BatchJob& job = m_jobs[m_workerJobs[worker]];
+  job.duration = m_workerTimes[worker].Time();
+  job.exitCode = event.GetExitCode();
+
+  // the worker reports "peak-memory <kB>" on stdout
+  int peak = job.output.Find(wxT("peak-memory "));
+  if (peak > -1)
+    job.output.Mid(peak + 12).BeforeFirst(wxT('\n')).ToLong(&job.peakMemory);
+
+  wxString status = wxT("ok");
+  if (job.exitCode != 0)
+    status = wxString::Format(wxT("FAIL(%d)"), job.exitCode);
+  wxPrintf(wxT("%-8s %10.1f %12ld  %s\n"), status.c_str(),
+           job.duration / 1000.0, job.peakMemory, job.file.c_str());
+  fflush(stdout);
+
+  delete m_processes[worker];
+  m_processes[worker] = NULL;
+  m_running--;
+}
+
+void BatchRunner::Finish()
+{
+  m_timer.Stop();
+
+  long failed = 0;
+  for (size_t i = 0; i < m_jobs.size(); i++) {
+    if (m_jobs[i].exitCode != 0) {
+      failed++;
+      wxFprintf(stderr, wxT("\n%s (exit status %d):\n%s\n"), m_jobs[i].file.c_str(),
+                m_jobs[i].exitCode, m_jobs[i].output.Trim().c_str());
+    }
+  }
+
+  wxPrintf(wxT("\n%lu documents, %ld failed, %.1f s with %lu workers\n"),
+           (unsigned long)m_jobs.size(), failed, m_stopwatch.Time() / 1000.0,
+           (unsigned long)m_processes.size());
+  fflush(stdout);
+
+  wxGetApp().SetExitCode(failed > 0 ? 1 : 0);
+  wxGetApp().ExitMainLoop();
+}
+
+BEGIN_EVENT_TABLE(BatchRunner, wxEvtHandler)
+  EVT_END_PROCESS(wxID_ANY, BatchRunner::OnProcessEvent)
+  EVT_TIMER(batch_timer_id, BatchRunner::OnTimer)
+END_EVENT_TABLE()
@@ -0,0 +1,76 @@
+///
+///  Copyright (C) 2004-2011 Andrej Vodopivec <andrej.vodopivec@gmail.com>
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///
+///  You should have received a copy of the GNU General Public License
+///  along with this program; if not, write to the Free Software
+///  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+///
+
+
+#ifndef _BATCHRUNNER_H_
+#define _BATCHRUNNER_H_
+
+#include <wx/wx.h>
+#include <wx/process.h>
+#include <wx/stopwatch.h>
+#include <wx/timer.h>
+#include <vector>
+
+#include "Utf8Decoder.h"
+
+struct BatchJob
+{
+  BatchJob() : duration(-1), peakMemory(-1), exitCode(-1) { }
+  wxString file;
+  long duration;     // ms
+  long peakMemory;   // kB, wxMaxima and Maxima together, -1 if unknown
+  int exitCode;
+  wxString output;   // what the worker wrote to stdout and stderr
+};
+
+/***
+ * BatchRunner evaluates many documents at once. Every document is
+ * evaluated by its own "wxmaxima --batch" process, which starts its own
+ * Maxima on the next free port; at most workers of them run at a time.
+ */
+class BatchRunner : public wxEvtHandler
+{
+public:
+  BatchRunner(const wxArrayString& files, int workers);
+  ~BatchRunner();
+  void Start();
+  static void CollectFiles(const wxArrayString& args, wxArrayString& files);
+  static long PeakMemory(long maximaPid);
+protected:
+  void OnProcessEvent(wxProcessEvent& event);
+  void OnTimer(wxTimerEvent& event);
+private:
+  void StartNext(size_t worker);
+  void Drain(size_t worker);
+  static void Drain(wxInputStream *stream, Utf8Decoder& decoder, wxString& output);
+  void Finish();
+  std::vector<BatchJob> m_jobs;
+  std::vector<wxProcess*> m_processes; // per worker, NULL when idle
+  std::vector<size_t> m_workerJobs;    // the job each worker runs
+  std::vector<wxStopWatch> m_workerTimes;
+  std::vector<Utf8Decoder> m_outputDecoders; // per worker, for stdout
+  std::vector<Utf8Decoder> m_errorDecoders;  // and stderr
+  size_t m_next;
+  size_t m_running;
+  wxStopWatch m_stopwatch;
+  wxTimer m_timer;
+  DECLARE_EVENT_TABLE()
+};
+
+#endif //_BATCHRUNNER_H_
@@ -0,0 +1,701 @@
+///
+///  Copyright (C) 2004-2011 Andrej Vodopivec <andrej.vodopivec@gmail.com>
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///
+///  You should have received a copy of the GNU General Public License
+///  along with this program; if not, write to the Free Software
+///  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+///
+
+
+/***
+ * wxmaxima-bench measures the rendering engine without the GUI: parsing
+ * a document, layout, drawing into an offscreen bitmap and exporting it.
+ * It loads a .wxm or .wxmx file or generates a synthetic worksheet and
+ * prints time, allocations and peak RSS for every phase, one line each.
+ *
+ * With --scaling it runs the parts of wxMaxima which must stay linear at
+ * 1x, 4x and 16x input size instead, and fails if the growth exponent fitted
+ * to the times exceeds SCALING_MAX_EXPONENT.
+ */
+
+#include <wx/wx.h>
+#include <wx/app.h>
+#include <wx/cmdline.h>
+#include <wx/config.h>
+#include <wx/filename.h>
+#include <wx/fs_zip.h>
+#include <wx/image.h>
+#include <wx/sstream.h>
+#include <wx/stopwatch.h>
+#include <vector>
+#include <new>
+#include <stdlib.h>
+#include <math.h>
+
+#if !defined __WXMSW__
+#include <sys/resource.h>
+#endif
+
+#include "CellParser.h"
+#include "GroupCell.h"
+#include "DocumentReader.h"
+#include "MathParser.h"
+#include "EditorCell.h"
+#include "EvaluationQueue.h"
+#include "Autocomplete.h"
+
+#define BENCH_PAGE_HEIGHT 768
+#define BENCH_PLOT_WIDTH 400
+#define BENCH_PLOT_HEIGHT 300
+
+#define SCALING_MAX_EXPONENT 1.5 // n log n passes, n^2 does not
+#define SCALING_MIN_TIME 50      // ms measured for every size
+#define SCALING_MAX_RUNS 1000
+
+// Allocations done with new since the start of the program
+static size_t allocCount = 0;
+static size_t allocBytes = 0;
+
+void* operator new(size_t size)
+{
+  allocCount++;
+  allocBytes += size;
+  void *p = malloc(size > 0 ? size : 1);
+  if (p == NULL)
+    throw std::bad_alloc();
+  return p;
+}
+
+void* operator new[](size_t size)
+{
+  return operator new(size);
+}
+
+void operator delete(void *p) throw()
+{
+  free(p);
+}
+
+void operator delete[](void *p) throw()
+{
+  free(p);
+}
+
+/***
+ * Peak resident set size in kB, -1 where it is not known.
+ */
+static long PeakRSS()
+{
+#if defined __WXMSW__
+  return -1;
+#else
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+    return -1;
+#if defined __WXMAC__
+  return usage.ru_maxrss / 1024; // bytes on Mac OS X
+#else
+  return usage.ru_maxrss;
+#endif
+#endif
+}
+
+/***
+ * Measures one phase, from the constructor to Report.
+ */
+class BenchPhase
+{
+public:
+  BenchPhase(wxString name)
+  {
+    m_name = name;
+    m_allocCount = allocCount;
+    m_allocBytes = allocBytes;
+    m_stopwatch.Start();
+  }
+  void Report()
+  {
+    long time = m_stopwatch.Time();
+    wxPrintf(wxT("%-10s %10ld %12lu %12lu %12ld\n"), m_name.c_str(), time,
+             (unsigned long)(allocCount - m_allocCount),
+             (unsigned long)((allocBytes - m_allocBytes) / 1024), PeakRSS());
+    fflush(stdout);
+  }
+private:
+  wxString m_name;
+  size_t m_allocCount, m_allocBytes;
+  wxStopWatch m_stopwatch;
+};
+
+/***
+ * ms since stopwatch was started, with sub-ms resolution where available.
+ */
+static double Elapsed(wxStopWatch& stopwatch)
+{
+#if wxCHECK_VERSION(2,9,0)
+  return stopwatch.TimeInMicro().ToDouble() / 1000.0;
+#else
+  return stopwatch.Time();
+#endif
+}
+
+static void DestroyTree(MathCell *tree)
+{
+  while (tree != NULL) {
+    MathCell *tmp = tree;
+    tree = tree->m_next;
+    tmp->Destroy();
+    delete tmp;
+  }
+}
+
+class BenchApp;
+
+// A scaling check does its setup, and returns the ms its operation took
+// for an input of the given size.
+typedef double (BenchApp::*ScalingCheck)(long size);
+
+class BenchApp : public wxApp
+{
+public:
+  virtual bool OnInit();
+  virtual int OnRun();
+  virtual void OnInitCmdLine(wxCmdLineParser& parser);
+  virtual bool OnCmdLineParsed(wxCmdLineParser& parser);
+private:
+  GroupCell* Load();
+  wxString GenerateWorksheet(long groups, long terms, long plots);
+  wxString GenerateOutput(long group, long terms);
+  wxString GeneratePlot();
+  int Layout(GroupCell *tree, int clientWidth, bool force);
+  void Draw(GroupCell *tree, int height);
+  int RunScaling();
+  bool CheckScaling(const wxChar *name, ScalingCheck check, long size);
+  double ParseOutput(long size);
+  double LayoutGroups(long size);
+  double LoadWXMX(long size);
+  double SaveWXMX(long size);
+  double LoadWXM(long size);
+  double CompleteSymbols(long size);
+  double FindReplace(long size);
+  double QueueGroups(long size);
+  wxString m_file;
+  long m_groups, m_terms, m_plots;
+  long m_width, m_zoom;
+  bool m_scaling;
+  wxString m_plotFile;
+};
+
+IMPLEMENT_APP(BenchApp)
+
+void BenchApp::OnInitCmdLine(wxCmdLineParser& parser)
+{
+  parser.AddSwitch(wxT("h"), wxT("help"), wxT("show this help"),
+                   wxCMD_LINE_OPTION_HELP);
+  parser.AddOption(wxT("n"), wxT("groups"), wxT("groups in the synthetic worksheet (default 1000)"),
+                   wxCMD_LINE_VAL_NUMBER);
+  parser.AddOption(wxT("m"), wxT("terms"), wxT("terms in each output (default 20)"),
+                   wxCMD_LINE_VAL_NUMBER);
+  parser.AddOption(wxT("k"), wxT("plots"), wxT("plots in the synthetic worksheet (default 10)"),
+                   wxCMD_LINE_VAL_NUMBER);
+  parser.AddOption(wxT("w"), wxT("width"), wxT("client width in pixels (default 800)"),
+                   wxCMD_LINE_VAL_NUMBER);
+  parser.AddOption(wxT("z"), wxT("zoom"), wxT("zoom in percent (default 100)"),
+                   wxCMD_LINE_VAL_NUMBER);
+  parser.AddSwitch(wxT("c"), wxT("scaling"), wxT("fail if a part of wxMaxima does not scale linearly"));
+  parser.AddParam(wxT(".wxm or .wxmx file, a synthetic worksheet is used without it"),
+                  wxCMD_LINE_VAL_STRING, wxCMD_LINE_PARAM_OPTIONAL);
+}
+
+bool BenchApp::OnCmdLineParsed(wxCmdLineParser& parser)
+{
+  m_groups = 1000;
+  m_terms = 20;
+  m_plots = 10;
+  m_width = 800;
+  m_zoom = 100;
+
+  parser.Found(wxT("n"), &m_groups);
+  parser.Found(wxT("m"), &m_terms);
+  parser.Found(wxT("k"), &m_plots);
+  parser.Found(wxT("w"), &m_width);
+  parser.Found(wxT("z"), &m_zoom);
+  m_scaling = parser.Found(wxT("c"));
+
+  if (parser.GetParamCount() > 0)
+    m_file = parser.GetParam(0);
+
+  return true;
+}
+
+bool BenchApp::OnInit()
+{
+  if (!wxApp::OnInit())
+    return false;
+
+  // use the styles of wxMaxima
+  wxConfig::Set(new wxConfig(wxT("wxMaxima")));
+
+  wxImage::AddHandler(new wxPNGHandler);
+  wxImage::AddHandler(new wxXPMHandler);
+  wxImage::AddHandler(new wxJPEGHandler);
+
+  wxFileSystem::AddHandler(new wxZipFSHandler);
+
+  return true;
+}
+
+int BenchApp::OnRun()
+{
+  if (m_scaling)
+    return RunScaling();
+
+  wxPrintf(wxT("%-10s %10s %12s %12s %12s\n"), wxT("phase"), wxT("time[ms]"),
+           wxT("allocs"), wxT("alloc[kB]"), wxT("peakRSS[kB]"));
+
+  BenchPhase parse(wxT("parse"));
+  GroupCell *tree = Load();
+  if (tree == NULL) {
+    wxFprintf(stderr, wxT("wxmaxima-bench: can not load %s\n"), m_file.c_str());
+    return 1;
+  }
+  parse.Report();
+
+  int clientWidth = m_width - MC_GROUP_LEFT_INDENT - MC_BASE_INDENT;
+
+  BenchPhase layout(wxT("layout"));
+  int height = Layout(tree, clientWidth, true);
+  layout.Report();
+
+  // change of the window width: line breaking only
+  BenchPhase reflow(wxT("reflow"));
+  Layout(tree, clientWidth * 3 / 4, false);
+  height = Layout(tree, clientWidth, false);
+  reflow.Report();
+
+  BenchPhase draw(wxT("draw"));
+  Draw(tree, height);
+  draw.Report();
+
+  BenchPhase xml(wxT("xml"));
+  size_t length = 0;
+  for (MathCell *tmp = tree; tmp != NULL; tmp = tmp->m_next)
+    length += tmp->ToXML(false).Length();
+  xml.Report();
+
+  BenchPhase tex(wxT("tex"));
+  for (MathCell *tmp = tree; tmp != NULL; tmp = tmp->m_next)
+    length += tmp->ToTeX(false).Length();
+  tex.Report();
+
+  long groups = 0;
+  for (MathCell *tmp = tree; tmp != NULL; tmp = tmp->m_next)
+    groups++;
+
+  BenchPhase destroy(wxT("destroy"));
+  DestroyTree(tree);
+  destroy.Report();
+
+  wxPrintf(wxT("# %ld groups, %d pixels high, %lu characters exported\n"),
+           groups, height, (unsigned long)length);
+
+  if (m_plotFile.Length())
+    wxRemoveFile(m_plotFile);
+
+  return 0;
+}
+
+/***
+ * Load the document given on the command line or the synthetic worksheet.
+ */
+GroupCell* BenchApp::Load()
+{
+  if (m_file.Right(5).Lower() == wxT(".wxmx")) {
+    wxXmlDocument xmldoc;
+    if (!DocumentReader::LoadWXMXFile(m_file, xmldoc))
+      return NULL;
+    return DocumentReader::CreateTreeFromXMLNode(xmldoc.GetRoot()->GetChildren(), m_file);
+  }
+
+  if (m_file.Length()) {
+    wxArrayString wxmLines;
+    if (!DocumentReader::ReadWXMFile(m_file, wxmLines))
+      return NULL;
+    return DocumentReader::CreateTreeFromWXMCode(&wxmLines);
+  }
+
+  wxStringInputStream stream(GenerateWorksheet(m_groups, m_terms, m_plots));
+  wxXmlDocument xmldoc;
+  if (!xmldoc.Load(stream))
+    return NULL;
+  return DocumentReader::CreateTreeFromXMLNode(xmldoc.GetRoot()->GetChildren());
+}
+
+/***
+ * The content.xml of a worksheet with groups code cells. Each output is a
+ * sum of terms terms with powers, fractions and Greek letters; plots of
+ * the groups show an image instead.
+ */
+wxString BenchApp::GenerateWorksheet(long groups, long terms, long plots)
+{
+  wxString plot;
+  if (plots > 0)
+    plot = GeneratePlot();
+
+  wxString xml = wxT("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n")
+                 wxT("<wxMaximaDocument version=\"1.1\" zoom=\"100\">\n");
+
+  long plotEvery = plots > 0 ? MAX(groups / plots, 1) : 0;
+  long plotCount = 0;
+
+  for (long i = 1; i <= groups; i++) {
+    xml += wxT("<cell type=\"code\">\n<input>\n<editor type=\"input\">\n");
+    xml += wxString::Format(wxT("<line>expand((x+%%alpha)^%ld);</line>\n"), terms);
+    xml += wxT("</editor>\n</input>\n<output>\n<mth>");
+
+    if (plotEvery > 0 && plotCount < plots && i % plotEvery == 0) {
+      xml += wxString::Format(wxT("<lbl>(%%t%ld) </lbl><img del=\"no\">"), i);
+      xml += plot + wxT("</img>");
+      plotCount++;
+    }
+    else
+      xml += GenerateOutput(i, terms);
+
+    xml += wxT("</mth></output>\n</cell>\n");
+  }
+
+  xml += wxT("</wxMaximaDocument>\n");
+  return xml;
+}
+
+/***
+ * The output of one group as Maxima sends it, without <mth>.
+ */
+wxString BenchApp::GenerateOutput(long group, long terms)
+{
+  wxString xml = wxString::Format(wxT("<lbl>(%%o%ld) </lbl>"), group);
+
+  for (long j = 1; j <= terms; j++) {
+    if (j > 1)
+      xml += wxT("<v>+</v>");
+    if (j % 5 == 0)
+      xml += wxString::Format(wxT("<f><r><n>%ld</n></r><r><n>%ld</n></r></f>"), j, group);
+    else
+      xml += wxString::Format(wxT("<n>%ld</n>"), group + j);
+    xml += wxT("<h>*</h><g>%alpha</g><h>*</h>");
+    xml += wxString::Format(wxT("<e><r><v>x</v></r><r><n>%ld</n></r></e>"), j);
+  }
+
+  return xml;
+}
+
+/***
+ * Draw a plot like image into a temporary PNG file and return its name.
+ */
+wxString BenchApp::GeneratePlot()
+{
+  wxBitmap bitmap(BENCH_PLOT_WIDTH, BENCH_PLOT_HEIGHT);
+  wxMemoryDC dc;
+  dc.SelectObject(bitmap);
+  dc.SetBackground(*wxWHITE_BRUSH);
+  dc.Clear();
+  dc.SetPen(*wxBLACK_PEN);
+  dc.DrawRectangle(20, 20, BENCH_PLOT_WIDTH - 40, BENCH_PLOT_HEIGHT - 40);
+  dc.SetPen(*wxBLUE_PEN);
+  for (int x = 20; x < BENCH_PLOT_WIDTH - 20; x += 4)
+    dc.DrawLine(x, BENCH_PLOT_HEIGHT / 2 + (x * x) % 97 - 48,
+                x + 4, BENCH_PLOT_HEIGHT / 2 + ((x + 4) * (x + 4)) % 97 - 48);
+  dc.SelectObject(wxNullBitmap);
+
+  m_plotFile = wxFileName::CreateTempFileName(wxT("wxmaxima-bench"));
+  bitmap.SaveFile(m_plotFile, wxBITMAP_TYPE_PNG);
+  return m_plotFile;
+}
+
+/***
+ * Recalculate all groups for clientWidth like MathCtrl::Recalculate does and
+ * return the height of the document.
+ */
+int BenchApp::Layout(GroupCell *tree, int clientWidth, bool force)
+{
+  wxBitmap bitmap(1, 1);
+  wxMemoryDC dc;
+  dc.SelectObject(bitmap);
+
+  CellParser parser(dc);
+  parser.SetZoomFactor(double(m_zoom) / 100.0);
+  parser.SetClientWidth(clientWidth);
+  parser.SetForceUpdate(force);
+
+  wxPoint point;
+  point.x = MC_GROUP_LEFT_INDENT;
+  point.y = MC_BASE_INDENT;
+
+  for (GroupCell *tmp = tree; tmp != NULL; tmp = dynamic_cast<GroupCell*>(tmp->m_next)) {
+    tmp->Recalculate(parser, parser.GetDefaultFontSize(), parser.GetMathFontSize());
+    point.y += tmp->GetMaxCenter();
+    tmp->m_currentPoint.x = point.x;
+    tmp->m_currentPoint.y = point.y;
+    point.y += tmp->GetMaxDrop();
+    point.y += MC_GROUP_SKIP;
+  }
+
+  dc.SelectObject(wxNullBitmap);
+  return point.y;
+}
+
+/***
+ * Draw the whole document page by page into an offscreen bitmap, the way
+ * MathCtrl::OnPaint draws the visible part.
+ */
+void BenchApp::Draw(GroupCell *tree, int height)
+{
+  wxBitmap bitmap(m_width, BENCH_PAGE_HEIGHT);
+  wxMemoryDC dc;
+  dc.SelectObject(bitmap);
+  dc.SetBackground(*wxWHITE_BRUSH);
+  dc.SetBackgroundMode(wxTRANSPARENT);
+
+  CellParser parser(dc);
+  parser.SetZoomFactor(double(m_zoom) / 100.0);
+  int fontsize = MAX(parser.GetDefaultFontSize(), MC_MIN_SIZE);
+
+  for (int top = 0; top < height; top += BENCH_PAGE_HEIGHT) {
+    dc.SetDeviceOrigin(0, -top);
+    dc.Clear();
+    parser.SetBounds(top, top + BENCH_PAGE_HEIGHT);
+
+    for (GroupCell *tmp = tree; tmp != NULL; tmp = dynamic_cast<GroupCell*>(tmp->m_next)) {
+      wxPoint point = tmp->m_currentPoint;
+      if (tmp->DrawThisCell(parser, point))
+        tmp->Draw(parser, point, fontsize, false);
+    }
+  }
+
+  dc.SelectObject(wxNullBitmap);
+}
+
+int BenchApp::RunScaling()
+{
+  bool ok = true;
+
+  ok = CheckScaling(wxT("output parsing"), &BenchApp::ParseOutput, 1000) && ok;
+  ok = CheckScaling(wxT("layout"), &BenchApp::LayoutGroups, 100) && ok;
+  ok = CheckScaling(wxT("wxmx load"), &BenchApp::LoadWXMX, 100) && ok;
+  ok = CheckScaling(wxT("wxmx save"), &BenchApp::SaveWXMX, 100) && ok;
+  ok = CheckScaling(wxT("wxm load"), &BenchApp::LoadWXM, 2000) && ok;
+  ok = CheckScaling(wxT("autocompletion"), &BenchApp::CompleteSymbols, 2000) && ok;
+  ok = CheckScaling(wxT("find/replace"), &BenchApp::FindReplace, 2000) && ok;
+  ok = CheckScaling(wxT("evaluation queue"), &BenchApp::QueueGroups, 2000) && ok;
+
+  return ok ? 0 : 1;
+}
+
+/***
+ * Time check at size, 4 * size and 16 * size and fit the exponent of the
+ * growth by least squares on the log-log curve.
+ */
+bool BenchApp::CheckScaling(const wxChar *name, ScalingCheck check, long size)
+{
+  const int points = 3;
+  long sizes[points];
+  double times[points];
+  double sx = 0, sy = 0, sxx = 0, sxy = 0;
+
+  for (int i = 0; i < points; i++, size *= 4)
+  {
+    double total = 0;
+    long runs = 0;
+    while (total < SCALING_MIN_TIME && runs < SCALING_MAX_RUNS) {
+      total += (this->*check)(size);
+      runs++;
+    }
+    sizes[i] = size;
+    times[i] = MAX(total / runs, 1e-3);
+
+    double x = log(double(sizes[i])), y = log(times[i]);
+    sx += x;
+    sy += y;
+    sxx += x * x;
+    sxy += x * y;
+  }
+
+  double exponent = (points * sxy - sx * sy) / (points * sxx - sx * sx);
+  bool ok = exponent <= SCALING_MAX_EXPONENT;
+
+  wxPrintf(wxT("%-20s exponent %5.2f %s\n"), name, exponent, ok ? wxT("ok") : wxT("FAILED"));
+  if (!ok)
+    for (int i = 0; i < points; i++)
+      wxPrintf(wxT("  size %8ld: %10.3f ms\n"), sizes[i], times[i]);
+  fflush(stdout);
+
+  return ok;
+}
+
+/// Parse one output with size terms, as MathParser::ParseLine does.
+double BenchApp::ParseOutput(long size)
+{
+  wxString xml = wxT("<mth>") + GenerateOutput(1, size) + wxT("</mth>");
+  MathParser parser;
+
+  wxStopWatch stopwatch;
+  wxXmlDocument xmldoc;
+  wxStringInputStream stream(xml);
+  xmldoc.Load(stream);
+  MathCell *cell = parser.ParseTag(xmldoc.GetRoot());
+  double time = Elapsed(stopwatch);
+
+  DestroyTree(cell);
+  return time;
+}
+
+/// Recalculate size groups with forced measuring.
+double BenchApp::LayoutGroups(long size)
+{
+  wxStringInputStream stream(GenerateWorksheet(size, 20, 0));
+  wxXmlDocument xmldoc;
+  xmldoc.Load(stream);
+  GroupCell *tree = DocumentReader::CreateTreeFromXMLNode(xmldoc.GetRoot()->GetChildren());
+
+  wxStopWatch stopwatch;
+  Layout(tree, m_width - MC_GROUP_LEFT_INDENT - MC_BASE_INDENT, true);
+  double time = Elapsed(stopwatch);
+
+  DestroyTree(tree);
+  return time;
+}
+
+/// Read the content.xml of a worksheet with size groups.
+double BenchApp::LoadWXMX(long size)
+{
+  wxString xml = GenerateWorksheet(size, 20, 0);
+
+  wxStopWatch stopwatch;
+  wxStringInputStream stream(xml);
+  wxXmlDocument xmldoc;
+  xmldoc.Load(stream);
+  GroupCell *tree = DocumentReader::CreateTreeFromXMLNode(xmldoc.GetRoot()->GetChildren());
+  double time = Elapsed(stopwatch);
+
+  DestroyTree(tree);
+  return time;
+}
+
+/// Write the content.xml of a worksheet with size groups, as
+/// MathCtrl::ExportToWXMX does.
+double BenchApp::SaveWXMX(long size)
+{
+  wxStringInputStream stream(GenerateWorksheet(size, 20, 0));
+  wxXmlDocument xmldoc;
+  xmldoc.Load(stream);
+  GroupCell *tree = DocumentReader::CreateTreeFromXMLNode(xmldoc.GetRoot()->GetChildren());
+
+  wxStopWatch stopwatch;
+  wxString xml = wxT("<wxMaximaDocument version=\"1.1\" zoom=\"100\">\n");
+  for (MathCell *tmp = tree; tmp != NULL; tmp = tmp->m_next)
+    xml += tmp->ToXML(false);
+  xml += wxT("\n</wxMaximaDocument>");
+  double time = Elapsed(stopwatch);
+
+  DestroyTree(tree);
+  return time;
+}
+
+/// Read a .wxm file with size input cells.
+double BenchApp::LoadWXM(long size)
+{
+  wxArrayString wxmLines;
+  wxmLines.Add(wxT("/* [wxMaxima batch file version 1] [ DO NOT EDIT BY HAND! ]*/"));
+  for (long i = 0; i < size; i++) {
+    wxmLines.Add(wxT("/* [wxMaxima: input   start ] */"));
+    wxmLines.Add(wxString::Format(wxT("f%ld(x) := x^%ld;"), i, i));
+    wxmLines.Add(wxT("/* [wxMaxima: input   end   ] */"));
+    wxmLines.Add(wxEmptyString);
+  }
+
+  wxStopWatch stopwatch;
+  GroupCell *tree = DocumentReader::CreateTreeFromWXMCode(&wxmLines);
+  double time = Elapsed(stopwatch);
+
+  DestroyTree(tree);
+  return time;
+}
+
+/// Add size symbols and templates, as SendMaxima does for definitions,
+/// and complete a prefix they all share.
+double BenchApp::CompleteSymbols(long size)
+{
+  AutoComplete autocomplete;
+
+  wxStopWatch stopwatch;
+  for (long i = 0; i < size; i++) {
+    autocomplete.AddSymbol(wxString::Format(wxT("sym%ld"), i));
+    autocomplete.AddSymbol(wxString::Format(wxT("sym%ld(<x>)"), i), true);
+  }
+  autocomplete.CompleteSymbol(wxT("sym"));
+  autocomplete.CompleteSymbol(wxT("sym"), true);
+  return Elapsed(stopwatch);
+}
+
+/// Step through all matches in a cell with size lines and replace them
+/// in size cells.
+double BenchApp::FindReplace(long size)
+{
+  wxString text;
+  for (long i = 0; i < size; i++)
+    text += wxT("x+1;\n");
+
+  EditorCell *editor = new EditorCell();
+  editor->SetValue(text);
+  std::vector<EditorCell*> editors;
+  for (long i = 0; i < size; i++) {
+    editors.push_back(new EditorCell());
+    editors.back()->SetValue(wxT("x+1;"));
+  }
+
+  wxStopWatch stopwatch;
+  while (editor->FindNext(wxT("x"), true, false))
+    ;
+  for (long i = 0; i < size; i++)
+    editors[i]->ReplaceAll(wxT("x"), wxT("y"));
+  double time = Elapsed(stopwatch);
+
+  DestroyTree(editor);
+  for (long i = 0; i < size; i++)
+    DestroyTree(editors[i]);
+  return time;
+}
+
+/// Queue size groups, check each of them like painting does and evaluate
+/// them.
+double BenchApp::QueueGroups(long size)
+{
+  std::vector<GroupCell*> groups;
+  for (long i = 0; i < size; i++)
+    groups.push_back(new GroupCell(GC_TYPE_CODE, wxT("1+1;")));
+
+  wxStopWatch stopwatch;
+  EvaluationQueue queue;
+  for (long i = 0; i < size; i++)
+    queue.AddToQueue(groups[i]);
+  for (long i = 0; i < size; i++)
+    queue.IsInQueue(groups[i]);
+  while (!queue.Empty())
+    queue.RemoveFirst();
+  double time = Elapsed(stopwatch);
+
+  for (long i = 0; i < size; i++)
+    DestroyTree(groups[i]);
+  return time;
+}
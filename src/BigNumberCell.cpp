@@ -0,0 +1,233 @@
+///
+///  Copyright (C) 2004-2011 Andrej Vodopivec <andrej.vodopivec@gmail.com>
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///
+///  You should have received a copy of the GNU General Public License
+///  along with this program; if not, write to the Free Software
+///  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+///
+
+
+#include "BigNumberCell.h"
+
+BigNumberCell::BigNumberCell(const wxString& digits) : MathCell()
+{
+  m_digits = std::string(digits.mb_str(wxConvUTF8));
+  for (size_t i = 0; i < m_digits.length(); i++)
+    if (m_digits[i] < '0' || m_digits[i] > '9')
+      m_others += GetDisplayed(i, 1);
+  m_groups = m_lastGroup = NULL;
+  m_fontSize = -1;
+  m_digitWidth = 0;
+  m_textStyle = TS_NUMBER;
+}
+
+BigNumberCell::~BigNumberCell()
+{
+  DestroyGroups();
+  if (m_next != NULL)
+    delete m_next;
+}
+
+void BigNumberCell::DestroyGroups()
+{
+  while (m_groups != NULL)
+  {
+    MathCell *tmp = m_groups;
+    m_groups = dynamic_cast<BigNumberCell*>(m_groups->m_next);
+    tmp->Destroy();
+    delete tmp;
+  }
+  m_lastGroup = NULL;
+}
+
+MathCell* BigNumberCell::Copy(bool all)
+{
+  BigNumberCell *tmp = new BigNumberCell(GetValue());
+  CopyData(this, tmp);
+  tmp->m_highlight = m_highlight;
+  if (all && m_next != NULL)
+    tmp->AppendCell(m_next->Copy(all));
+  return tmp;
+}
+
+void BigNumberCell::Destroy()
+{
+  DestroyGroups();
+  m_next = NULL;
+}
+
+/***
+ * The characters from start as they are drawn.
+ */
+wxString BigNumberCell::GetDisplayed(size_t start, size_t length)
+{
+  wxString text = wxString::FromAscii(m_digits.substr(start, length).c_str());
+#if wxUSE_UNICODE
+  text.Replace(wxT("-"), wxT("\x2212")); // unicode minus sign
+#endif
+  return text;
+}
+
+/***
+ * Break the number into groups of digits. The groups are made once and
+ * kept for later break ups.
+ */
+bool BigNumberCell::BreakUp()
+{
+  if (m_isBroken || m_digits.length() <= BIGNUM_GROUP)
+    return false;
+
+  if (m_groups == NULL)
+  {
+    for (size_t i = 0; i < m_digits.length(); i += BIGNUM_GROUP)
+    {
+      BigNumberCell *group =
+        new BigNumberCell(wxString::FromAscii(m_digits.substr(i, BIGNUM_GROUP).c_str()));
+      CopyData(this, group);
+      group->m_highlight = m_highlight;
+      group->m_forceBreakLine = (i == 0) && m_forceBreakLine;
+      group->SetParent(m_group, false);
+      if (m_lastGroup == NULL)
+        m_groups = group;
+      else
+      {
+        m_lastGroup->m_next = m_lastGroup->m_nextToDraw = group;
+        group->m_previous = group->m_previousToDraw = m_lastGroup;
+      }
+      m_lastGroup = group;
+    }
+  }
+
+  m_isBroken = true;
+  m_lastGroup->m_nextToDraw = m_nextToDraw;
+  if (m_nextToDraw != NULL)
+    m_nextToDraw->m_previousToDraw = m_lastGroup;
+  m_nextToDraw = m_groups;
+  m_groups->m_previousToDraw = this;
+  return true;
+}
+
+void BigNumberCell::Unbreak(bool all)
+{
+  if (m_isBroken)
+  {
+    for (MathCell *tmp = m_groups; tmp != NULL; tmp = tmp->m_next)
+    {
+      tmp->ResetData();
+      tmp->m_nextToDraw = tmp->m_next;
+    }
+  }
+  MathCell::Unbreak(all);
+}
+
+/***
+ * The width is computed from the advance of one digit and the width of
+ * the few other characters (sign, decimal point and exponent marker).
+ */
+void BigNumberCell::RecalculateWidths(CellParser& parser, int fontsize, bool all)
+{
+  if (m_height == -1 || m_width == -1 || fontsize != m_fontSize || parser.ForceUpdate())
+  {
+    m_fontSize = fontsize;
+
+    wxDC& dc = parser.GetDC();
+    double scale = parser.GetScale();
+    SetFont(parser, fontsize);
+
+    int othersWidth = 0, othersHeight;
+    dc.GetTextExtent(wxT("0"), &m_digitWidth, &m_height);
+    if (m_others.Length())
+      dc.GetTextExtent(m_others, &othersWidth, &othersHeight);
+
+    m_width = m_digitWidth * int(m_digits.length() - m_others.Length()) + othersWidth +
+              2 * SCALE_PX(MC_TEXT_PADDING, scale);
+    m_height = m_height + 2 * SCALE_PX(MC_TEXT_PADDING, scale);
+    m_center = m_height / 2;
+  }
+
+  for (MathCell *tmp = m_groups; m_isBroken && tmp != NULL; tmp = tmp->m_next)
+    tmp->RecalculateWidths(parser, fontsize, false);
+
+  MathCell::RecalculateWidths(parser, fontsize, all);
+}
+
+void BigNumberCell::RecalculateSize(CellParser& parser, int fontsize, bool all)
+{
+  MathCell::RecalculateSize(parser, fontsize, all);
+}
+
+/***
+ * A number of digits only is drawn only where it is visible.
+ */
+void BigNumberCell::Draw(CellParser& parser, wxPoint point, int fontsize, bool all)
+{
+  if (m_width == -1 || m_height == -1)
+    RecalculateWidths(parser, fontsize, false);
+
+  if (DrawThisCell(parser, point) && !m_isBroken)
+  {
+    wxDC& dc = parser.GetDC();
+    double scale = parser.GetScale();
+    int x = point.x + SCALE_PX(MC_TEXT_PADDING, scale);
+    int y = point.y - m_center + SCALE_PX(MC_TEXT_PADDING, scale);
+
+    SetFont(parser, fontsize);
+    SetForeground(parser);
+
+    size_t from = 0, length = m_digits.length();
+    if (m_others.Length() == 0 && m_digitWidth > 0 &&
+        parser.GetLeft() != -1 && parser.GetRight() != -1)
+    {
+      from = MAX(0, (parser.GetLeft() - x) / m_digitWidth);
+      length = MAX(0, (parser.GetRight() - x) / m_digitWidth + 1 - int(from));
+    }
+
+    if (from < m_digits.length())
+      dc.DrawText(GetDisplayed(from, length), x + int(from) * m_digitWidth, y);
+  }
+  MathCell::Draw(parser, point, fontsize, all);
+}
+
+void BigNumberCell::SetFont(CellParser& parser, int fontsize)
+{
+  double scale = parser.GetScale();
+  int fontsize1 = (int) (((double)fontsize) * scale + 0.5);
+  fontsize1 = MAX(fontsize1, 1);
+
+  parser.GetDC().SetFont(wxFont(fontsize1, wxFONTFAMILY_MODERN,
+                                parser.IsItalic(m_textStyle),
+                                parser.IsBold(m_textStyle),
+                                parser.IsUnderlined(m_textStyle),
+                                parser.GetFontName(m_textStyle),
+                                parser.GetFontEncoding()));
+}
+
+wxString BigNumberCell::ToString(bool all)
+{
+  if (m_isBroken)
+    return MathCell::ToString(all);
+  return GetValue() + MathCell::ToString(all);
+}
+
+wxString BigNumberCell::ToTeX(bool all)
+{
+  if (m_isBroken)
+    return MathCell::ToTeX(all);
+  return GetValue() + MathCell::ToTeX(all);
+}
+
+wxString BigNumberCell::ToXML(bool all)
+{
+  return wxT("<n>") + GetValue() + wxT("</n>") + MathCell::ToXML(all);
+}
@@ -0,0 +1,67 @@
+///
+///  Copyright (C) 2004-2011 Andrej Vodopivec <andrej.vodopivec@gmail.com>
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///
+///  You should have received a copy of the GNU General Public License
+///  along with this program; if not, write to the Free Software
+///  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+///
+
+
+#ifndef _BIGNUMBERCELL_H_
+#define _BIGNUMBERCELL_H_
+
+#include "MathCell.h"
+
+#include <string>
+
+#define BIGNUM_MIN 100     // longer numbers get a BigNumberCell
+#define BIGNUM_GROUP 10    // digits in a group when the number is broken up
+#define BIGNUM_ELIDE 10000 // longer numbers are elided in the middle
+#define BIGNUM_SHOWN 1000  // digits shown on each side of the elision
+
+/***
+ * BigNumberCell shows a number with many digits. The digits are kept as
+ * ascii and measured from the advance of one digit, so a long number is
+ * laid out without measuring its text. A number wider than the window
+ * breaks up into groups of BIGNUM_GROUP digits, which are wrapped at
+ * the client width like any other cells.
+ */
+class BigNumberCell : public MathCell
+{
+public:
+  BigNumberCell(const wxString& digits);
+  ~BigNumberCell();
+  MathCell* Copy(bool all);
+  void Destroy();
+  wxString GetValue() { return wxString::FromAscii(m_digits.c_str()); }
+  bool BreakUp();
+  void Unbreak(bool all);
+  void RecalculateWidths(CellParser& parser, int fontsize, bool all);
+  void RecalculateSize(CellParser& parser, int fontsize, bool all);
+  void Draw(CellParser& parser, wxPoint point, int fontsize, bool all);
+  wxString ToString(bool all);
+  wxString ToTeX(bool all);
+  wxString ToXML(bool all);
+private:
+  void SetFont(CellParser& parser, int fontsize);
+  wxString GetDisplayed(size_t start, size_t length);
+  void DestroyGroups();
+  std::string m_digits;
+  wxString m_others;   // the characters which are not digits
+  BigNumberCell *m_groups, *m_lastGroup;
+  int m_fontSize;
+  int m_digitWidth;
+};
+
+#endif //_BIGNUMBERCELL_H_
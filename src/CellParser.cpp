@@ -29,6 +29,10 @@ CellParser::CellParser(wxDC& dc) : m_dc(dc)
   m_zoomFactor = 1.0; // affects returned fontsizes
   m_top = -1;
   m_bottom = -1;
+  m_left = -1;
+  m_right = -1;
+  m_visible = wxRect(0, 0, -1, -1);
+  m_clientWidth = -1;
   m_forceUpdate = false;
   m_indent = MC_GROUP_LEFT_INDENT;
   m_changeAsterisk = false;
@@ -57,6 +61,10 @@ CellParser::CellParser(wxDC& dc, double scale) : m_dc(dc)
   m_zoomFactor = 1.0; // affects returned fontsizes
   m_top = -1;
   m_bottom = -1;
+  m_left = -1;
+  m_right = -1;
+  m_visible = wxRect(0, 0, -1, -1);
+  m_clientWidth = -1;
   m_forceUpdate = false;
   m_indent = MC_GROUP_LEFT_INDENT;
   m_changeAsterisk = false;
@@ -34,6 +34,7 @@ public:
   CellParser(wxDC& dc, double scale);
   ~CellParser();
   void SetZoomFactor(double newzoom) { m_zoomFactor = newzoom; }
+  double GetZoomFactor() { return m_zoomFactor; }
   void SetScale(double scale) { m_scale = scale; }
   double GetScale() { return m_scale; }
   wxDC& GetDC() { return m_dc; }
@@ -49,6 +50,14 @@ public:
   {
     return m_bottom;
   }
+  void SetHorizontalBounds(int left, int right) {
+    m_left = left;
+    m_right = right;
+  }
+  int GetLeft() { return m_left; }
+  int GetRight() { return m_right; }
+  void SetVisibleRegion(wxRect visible) { m_visible = visible; }
+  wxRect GetVisibleRegion() { return m_visible; }
   wxString GetFontName(int type = TS_DEFAULT);
   wxString GetSymbolFontName();
   wxColour GetColor(int st);
@@ -102,6 +111,8 @@ private:
   double m_zoomFactor;
   wxDC& m_dc;
   int m_top, m_bottom;
+  int m_left, m_right;
+  wxRect m_visible;
   wxString m_fontName;
   int m_defaultFontSize, m_mathFontSize;
   wxString m_mathFontName;
@@ -124,10 +124,17 @@ void Config::SetProperties()
   m_maximaProgram->SetToolTip(_("Enter the path to the Maxima executable."));
   m_additionalParameters->SetToolTip(_("Additional parameters for Maxima"
                                        " (e.g. -l clisp)."));
+  m_standbyMaxima->SetToolTip(_("Start and set up a second Maxima in the background,"
+                                " so that restarting Maxima only switches to it."));
+  m_compactDisplay->SetToolTip(_("Maxima sends results in a compact encoding which is faster"
+                                 " to read than XML. Needs a restart of Maxima."));
   m_saveSize->SetToolTip(_("Save wxMaxima window size/position between sessions."));
   m_savePanes->SetToolTip(_("Save panes layout between sessions."));
   m_matchParens->SetToolTip(_("Write matching parenthesis in text controls."));
   m_showLong->SetToolTip(_("Show long expressions in wxMaxima document."));
+  m_plainTextOutput->SetToolTip(_("Show output which needs no 2D layout as plain text, which is"
+                                  " much faster for long output. The output of a cell can be"
+                                  " switched back to 2D math from its context menu."));
   m_language->SetToolTip(_("Language used for wxMaxima GUI."));
   m_fixedFontInTC->SetToolTip(_("Set fixed font in text controls."));
   m_getFont->SetToolTip(_("Font used for display in document."));
@@ -142,6 +149,9 @@ void Config::SetProperties()
   bool enterEvaluates = false, saveUntitled = true, openHCaret = false;
   bool insertAns = true;
   bool fixReorderedIndices = false;
+  bool standbyMaxima = false;
+  bool compactDisplay = false;
+  bool plainTextOutput = false;
   int rs = 0;
   int lang = wxLANGUAGE_UNKNOWN;
   int panelSize = 1;
@@ -152,6 +162,7 @@ void Config::SetProperties()
   config->Read(wxT("pos-restore"), &rs);
   config->Read(wxT("matchParens"), &match);
   config->Read(wxT("showLong"), &showLongExpr);
+  config->Read(wxT("plainTextOutput"), &plainTextOutput);
   config->Read(wxT("language"), &lang);
   config->Read(wxT("changeAsterisk"), &changeAsterisk);
   config->Read(wxT("fixedFontTC"), &fixedFontTC);
@@ -161,6 +172,8 @@ void Config::SetProperties()
   config->Read(wxT("openHCaret"), &openHCaret);
   config->Read(wxT("insertAns"), &insertAns);
   config->Read(wxT("fixReorderedIndices"), &fixReorderedIndices);
+  config->Read(wxT("standbyMaxima"), &standbyMaxima);
+  config->Read(wxT("compactDisplay"), &compactDisplay);
   config->Read(wxT("usejsmath"), &usejsmath);
   config->Read(wxT("keepPercent"), &keepPercent);
 
@@ -209,12 +222,15 @@ void Config::SetProperties()
   m_savePanes->SetValue(savePanes);
   m_matchParens->SetValue(match);
   m_showLong->SetValue(showLongExpr);
+  m_plainTextOutput->SetValue(plainTextOutput);
   m_changeAsterisk->SetValue(changeAsterisk);
   m_enterEvaluates->SetValue(enterEvaluates);
   m_saveUntitled->SetValue(saveUntitled);
   m_openHCaret->SetValue(openHCaret);
   m_insertAns->SetValue(insertAns);
   m_fixReorderedIndices->SetValue(fixReorderedIndices);
+  m_standbyMaxima->SetValue(standbyMaxima);
+  m_compactDisplay->SetValue(compactDisplay);
   m_fixedFontInTC->SetValue(fixedFontTC);
   m_useJSMath->SetValue(usejsmath);
   m_keepPercentWithSpecials->SetValue(keepPercent);
@@ -273,6 +289,7 @@ wxPanel* Config::CreateOptionsPanel()
   m_matchParens = new wxCheckBox(panel, -1, _("Match parenthesis in text controls"));
   m_fixedFontInTC = new wxCheckBox(panel, -1, _("Fixed font in text controls"));
   m_showLong = new wxCheckBox(panel, -1, _("Show long expressions"));
+  m_plainTextOutput = new wxCheckBox(panel, -1, _("Show output as plain text"));
   m_changeAsterisk = new wxCheckBox(panel, -1, _("Use centered dot character for multiplication"));
   m_keepPercentWithSpecials = new wxCheckBox(panel, -1, _("Keep percent sign with special symbols: %e, %i, etc."));
   m_enterEvaluates = new wxCheckBox(panel, -1, _("Enter evaluates cells"));
@@ -295,6 +312,7 @@ wxPanel* Config::CreateOptionsPanel()
   vsizer->Add(m_matchParens, 0, wxALL, 5);
   vsizer->Add(m_fixedFontInTC, 0, wxALL, 5);
   vsizer->Add(m_showLong, 0, wxALL, 5);
+  vsizer->Add(m_plainTextOutput, 0, wxALL, 5);
   vsizer->Add(m_changeAsterisk, 0, wxALL, 5);
   vsizer->Add(m_keepPercentWithSpecials, 0, wxALL, 5);
   vsizer->Add(m_enterEvaluates, 0, wxALL, 5);
@@ -314,13 +332,15 @@ wxPanel* Config::CreateMaximaPanel()
 {
   wxPanel* panel = new wxPanel(m_notebook, -1);
 
-  wxFlexGridSizer* sizer = new wxFlexGridSizer(5, 2, 0, 0);
+  wxFlexGridSizer* sizer = new wxFlexGridSizer(7, 2, 0, 0);
 
   wxStaticText *mp = new wxStaticText(panel, -1, _("Maxima program:"));
   m_maximaProgram = new wxTextCtrl(panel, -1, wxEmptyString, wxDefaultPosition, wxSize(250, -1), wxTE_RICH);
   m_mpBrowse = new wxButton(panel, wxID_OPEN, _("Open"));
   wxStaticText *ap = new wxStaticText(panel, -1, _("Additional parameters:"));
   m_additionalParameters = new wxTextCtrl(panel, -1, wxEmptyString, wxDefaultPosition, wxSize(250, -1), wxTE_RICH);
+  m_standbyMaxima = new wxCheckBox(panel, -1, _("Keep a spare Maxima running for fast restarts"));
+  m_compactDisplay = new wxCheckBox(panel, -1, _("Use compact display protocol"));
 
   sizer->Add(mp, 0, wxALL | wxALIGN_CENTER_VERTICAL, 5);
   sizer->Add(10, 10);
@@ -331,6 +351,10 @@ wxPanel* Config::CreateMaximaPanel()
   sizer->Add(ap, 0, wxALL | wxALIGN_CENTER_VERTICAL, 5);
   sizer->Add(10, 10);
   sizer->Add(m_additionalParameters, 0, wxALL, 5);
+  sizer->Add(10, 10);
+  sizer->Add(m_standbyMaxima, 0, wxALL, 5);
+  sizer->Add(10, 10);
+  sizer->Add(m_compactDisplay, 0, wxALL, 5);
 
   panel->SetSizer(sizer);
   sizer->Fit(panel);
@@ -455,6 +479,7 @@ void Config::WriteSettings()
   config->Write(wxT("mathFontsize"), m_mathFontSize);
   config->Write(wxT("matchParens"), m_matchParens->GetValue());
   config->Write(wxT("showLong"), m_showLong->GetValue());
+  config->Write(wxT("plainTextOutput"), m_plainTextOutput->GetValue());
   config->Write(wxT("fixedFontTC"), m_fixedFontInTC->GetValue());
   config->Write(wxT("changeAsterisk"), m_changeAsterisk->GetValue());
   config->Write(wxT("enterEvaluates"), m_enterEvaluates->GetValue());
@@ -462,6 +487,8 @@ void Config::WriteSettings()
   config->Write(wxT("openHCaret"), m_openHCaret->GetValue());
   config->Write(wxT("insertAns"), m_insertAns->GetValue());
   config->Write(wxT("fixReorderedIndices"), m_fixReorderedIndices->GetValue());
+  config->Write(wxT("standbyMaxima"), m_standbyMaxima->GetValue());
+  config->Write(wxT("compactDisplay"), m_compactDisplay->GetValue());
   config->Write(wxT("defaultPort"), m_defaultPort->GetValue());
   config->Write(wxT("AUI/savePanes"), m_savePanes->GetValue());
   config->Write(wxT("usejsmath"), m_useJSMath->GetValue());
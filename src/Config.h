@@ -101,11 +101,14 @@ protected:
   wxTextCtrl* m_maximaProgram;
   wxButton* m_mpBrowse;
   wxTextCtrl* m_additionalParameters;
+  wxCheckBox* m_standbyMaxima;
+  wxCheckBox* m_compactDisplay;
   wxComboBox* m_language;
   wxCheckBox* m_saveSize;
   wxCheckBox* m_savePanes;
   wxCheckBox* m_matchParens;
   wxCheckBox* m_showLong;
+  wxCheckBox* m_plainTextOutput;
   wxCheckBox* m_enterEvaluates;
   wxCheckBox* m_saveUntitled;
   wxCheckBox* m_openHCaret;
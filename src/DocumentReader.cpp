@@ -0,0 +1,284 @@
+///
+///  Copyright (C) 2004-2011 Andrej Vodopivec <andrej.vodopivec@gmail.com>
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///
+///  You should have received a copy of the GNU General Public License
+///  along with this program; if not, write to the Free Software
+///  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+///
+
+
+#include "DocumentReader.h"
+#include "MathParser.h"
+
+#include <wx/textfile.h>
+#include <wx/filesys.h>
+
+/***
+ * Read the lines of a .wxm file. Returns false if the file can not be
+ * read or is not a wxMaxima batch file.
+ */
+bool DocumentReader::ReadWXMFile(wxString file, wxArrayString& wxmLines)
+{
+  wxTextFile inputFile(file);
+
+  if (!inputFile.Open())
+    return false;
+
+  if (inputFile.GetFirstLine() !=
+      wxT("/* [wxMaxima batch file version 1] [ DO NOT EDIT BY HAND! ]*/"))
+  {
+    inputFile.Close();
+    return false;
+  }
+
+  wxString line;
+  for (line = inputFile.GetFirstLine();
+       !inputFile.Eof();
+       line = inputFile.GetNextLine()) {
+    wxmLines.Add(line);
+  }
+  wxmLines.Add(line);
+
+  inputFile.Close();
+  return true;
+}
+
+/***
+ * Load content.xml of a .wxmx file. Returns false if it can not be read
+ * or is not a wxMaxima document.
+ */
+bool DocumentReader::LoadWXMXFile(wxString file, wxXmlDocument& xmldoc)
+{
+  wxFileSystem fs;
+  wxFSFile *fsfile = fs.OpenFile(wxT("file:") + file + wxT("#zip:content.xml"));
+
+  if ((fsfile == NULL) || (!xmldoc.Load(*(fsfile->GetStream())))) {
+    delete fsfile;
+    return false;
+  }
+
+  delete fsfile;
+
+  return xmldoc.GetRoot()->GetName() == wxT("wxMaximaDocument");
+}
+
+GroupCell* DocumentReader::CreateTreeFromXMLNode(wxXmlNode *xmlcells, wxString wxmxfilename,
+                                                 bool *complete)
+{
+  MathParser mp(wxmxfilename);
+  MathCell *tree = NULL;
+  MathCell *last = NULL;
+
+  if (complete != NULL)
+    *complete = true;
+
+  if (xmlcells) {
+    last = tree = mp.ParseTag(xmlcells, false); // first cell
+    while (xmlcells->GetNext()) {
+      xmlcells = xmlcells->GetNext();
+      MathCell *cell = mp.ParseTag(xmlcells, false);
+
+      if (cell != NULL)
+      {
+        last->m_next = last->m_nextToDraw = cell;
+        last->m_next->m_previous = last->m_next->m_previousToDraw = last;
+
+        last = last->m_next;
+      }
+      else if (complete != NULL)
+        *complete = false;
+    }
+  }
+
+  return dynamic_cast<GroupCell*>(tree);
+}
+
+GroupCell* DocumentReader::CreateTreeFromWXMCode(wxArrayString* wxmLines)
+{
+  size_t line = 0;
+  return CreateTreeFromWXMCode(wxmLines, line);
+}
+
+/***
+ * Create the groups from wxmLines starting at line, up to the end of the
+ * fold or the file. Lines are not removed from the array, which would make
+ * reading a long file quadratic.
+ */
+GroupCell* DocumentReader::CreateTreeFromWXMCode(wxArrayString* wxmLines, size_t& line)
+{
+  bool hide = false;
+  GroupCell* tree = NULL;
+  GroupCell* last = NULL;
+  GroupCell* cell = NULL;
+
+  while (line < wxmLines->GetCount())
+  {
+    if (wxmLines->Item(line) == wxT("/* [wxMaxima: hide output   ] */"))
+      hide = true;
+
+    // Print title
+    else if (wxmLines->Item(line) == wxT("/* [wxMaxima: title   start ]"))
+    {
+      line++;
+
+      wxString text;
+      while (wxmLines->Item(line) != wxT("   [wxMaxima: title   end   ] */"))
+      {
+        if (text.Length() == 0)
+          text = wxmLines->Item(line);
+        else
+          text += wxT("\n") + wxmLines->Item(line);
+
+        line++;
+      }
+
+      cell = new GroupCell(GC_TYPE_TITLE, text);
+      if (hide) {
+        cell->Hide(true);
+        hide = false;
+      }
+    }
+
+    // Print section
+    else if (wxmLines->Item(line) == wxT("/* [wxMaxima: section start ]"))
+    {
+      line++;
+
+      wxString text;
+      while (wxmLines->Item(line) != wxT("   [wxMaxima: section end   ] */"))
+      {
+        if (text.Length() == 0)
+          text = wxmLines->Item(line);
+        else
+          text += wxT("\n") + wxmLines->Item(line);
+
+        line++;
+      }
+
+      cell = new GroupCell(GC_TYPE_SECTION, text);
+      if (hide) {
+        cell->Hide(true);
+        hide = false;
+      }
+    }
+
+    // Print section
+    else if (wxmLines->Item(line) == wxT("/* [wxMaxima: subsect start ]"))
+    {
+      line++;
+
+      wxString text;
+      while (wxmLines->Item(line) != wxT("   [wxMaxima: subsect end   ] */"))
+      {
+        if (text.Length() == 0)
+          text = wxmLines->Item(line);
+        else
+          text += wxT("\n") + wxmLines->Item(line);
+
+        line++;
+      }
+
+      cell = new GroupCell(GC_TYPE_SUBSECTION, text);
+      if (hide) {
+        cell->Hide(true);
+        hide = false;
+      }
+    }
+
+    // Print comment
+    else if (wxmLines->Item(line) == wxT("/* [wxMaxima: comment start ]"))
+    {
+      line++;
+
+      wxString text;
+      while (wxmLines->Item(line) != wxT("   [wxMaxima: comment end   ] */"))
+      {
+        if (text.Length() == 0)
+          text = wxmLines->Item(line);
+        else
+          text += wxT("\n") + wxmLines->Item(line);
+
+        line++;
+      }
+
+      cell = new GroupCell(GC_TYPE_TEXT, text);
+      if (hide) {
+        cell->Hide(true);
+        hide = false;
+      }
+    }
+
+    // Print input
+    else if (wxmLines->Item(line) == wxT("/* [wxMaxima: input   start ] */"))
+    {
+      line++;
+
+      wxString text;
+      while (wxmLines->Item(line) != wxT("/* [wxMaxima: input   end   ] */"))
+      {
+        if (text.Length() == 0)
+          text = wxmLines->Item(line);
+        else
+          text += wxT("\n") + wxmLines->Item(line);
+
+        line++;
+      }
+
+      cell = new GroupCell(GC_TYPE_CODE, text);
+      if (hide) {
+        cell->Hide(true);
+        hide = false;
+      }
+    }
+
+    else if (wxmLines->Item(line) == wxT("/* [wxMaxima: page break    ] */"))
+    {
+      line++;
+
+      cell = new GroupCell(GC_TYPE_PAGEBREAK);
+    }
+
+    else if (wxmLines->Item(line) == wxT("/* [wxMaxima: fold    start ] */"))
+    {
+      line++;
+
+      last->HideTree(CreateTreeFromWXMCode(wxmLines, line));
+    }
+
+    else if (wxmLines->Item(line) == wxT("/* [wxMaxima: fold    end   ] */"))
+    {
+      line++;
+
+      break;
+    }
+
+    if (cell) { // if we have created a cell in this pass
+      if (!tree)
+        tree = last = cell;
+      else {
+
+        last->m_next = last->m_nextToDraw = ((MathCell *)cell);
+        last->m_next->m_previous = last->m_next->m_previousToDraw = ((MathCell *)last);
+
+        last = (GroupCell *)last->m_next;
+
+      }
+      cell = NULL;
+    }
+
+    line++;
+  }
+
+  return tree;
+}
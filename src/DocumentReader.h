@@ -0,0 +1,45 @@
+///
+///  Copyright (C) 2004-2011 Andrej Vodopivec <andrej.vodopivec@gmail.com>
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///
+///  You should have received a copy of the GNU General Public License
+///  along with this program; if not, write to the Free Software
+///  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+///
+
+
+#ifndef _DOCUMENTREADER_H_
+#define _DOCUMENTREADER_H_
+
+#include <wx/wx.h>
+#include <wx/xml/xml.h>
+
+#include "GroupCell.h"
+
+/***
+ * DocumentReader builds the tree of GroupCells from .wxm and .wxmx files.
+ * It does not depend on the main window, so wxmaxima-bench uses it too.
+ */
+class DocumentReader
+{
+public:
+  static bool ReadWXMFile(wxString file, wxArrayString& wxmLines);
+  static bool LoadWXMXFile(wxString file, wxXmlDocument& xmldoc);
+  static GroupCell* CreateTreeFromXMLNode(wxXmlNode *xmlcells, wxString wxmxfilename = wxEmptyString,
+                                          bool *complete = NULL);
+  static GroupCell* CreateTreeFromWXMCode(wxArrayString *wxmLines);
+private:
+  static GroupCell* CreateTreeFromWXMCode(wxArrayString *wxmLines, size_t& line);
+};
+
+#endif //_DOCUMENTREADER_H_
@@ -1922,12 +1922,14 @@ int EditorCell::ReplaceAll(wxString oldString, wxString newString)
 bool EditorCell::FindNext(wxString str, bool down, bool ignoreCase)
 {
   int start = down ? 0 : m_text.Length();
-  wxString text(m_text);
+  wxString lowerText;
+  const wxString *text = &m_text; // copying long texts for every match is slow
 
   if (ignoreCase)
   {
     str.MakeLower();
-    text.MakeLower();
+    lowerText = m_text.Lower();
+    text = &lowerText;
   }
 
   if (m_selectionStart >= 0)
@@ -1945,9 +1947,9 @@ bool EditorCell::FindNext(wxString str, bool down, bool ignoreCase)
 
   int strStart = wxNOT_FOUND;
   if (down)
-    strStart = text.find(str, start);
+    strStart = text->find(str, start);
   else
-    strStart = text.rfind(str, start);
+    strStart = text->rfind(str, start);
 
   if (strStart != wxNOT_FOUND)
   {
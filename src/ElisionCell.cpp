@@ -0,0 +1,98 @@
+///
+///  Copyright (C) 2004-2011 Andrej Vodopivec <andrej.vodopivec@gmail.com>
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///
+///  You should have received a copy of the GNU General Public License
+///  along with this program; if not, write to the Free Software
+///  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+///
+
+
+#include "ElisionCell.h"
+#include "MathParser.h"
+
+ElisionCell::ElisionCell(const wxString& hidden, int terms, bool digits) : TextCell()
+{
+  m_hidden = hidden;
+  m_terms = terms;
+  m_digits = digits;
+#if wxUSE_UNICODE
+  if (digits)
+    SetValue(wxString::Format(_(" \x2026 %d more digits \x2026 "), terms));
+  else
+    SetValue(wxString::Format(_(" \x2026 %d more terms \x2026 "), terms));
+#else
+  if (digits)
+    SetValue(wxString::Format(_(" ... %d more digits ... "), terms));
+  else
+    SetValue(wxString::Format(_(" ... %d more terms ... "), terms));
+#endif
+  m_textStyle = TS_DEFAULT;
+  m_highlight = true;
+}
+
+MathCell* ElisionCell::Copy(bool all)
+{
+  ElisionCell *tmp = new ElisionCell(m_hidden, m_terms, m_digits);
+  CopyData(this, tmp);
+  tmp->m_bigSkip = m_bigSkip;
+  tmp->m_highlight = m_highlight;
+  if (all && m_next != NULL)
+    tmp->AppendCell(m_next->Copy(all));
+  return tmp;
+}
+
+/***
+ * Parse the hidden terms. The caller owns the returned cells.
+ */
+MathCell* ElisionCell::Expand()
+{
+  MathParser parser;
+  return parser.ParseXml(wxT("<span>") + m_hidden + wxT("</span>"), m_type);
+}
+
+void ElisionCell::DestroyCells(MathCell *cells)
+{
+  while (cells != NULL)
+  {
+    MathCell *tmp = cells;
+    cells = cells->m_next;
+    tmp->Destroy();
+    delete tmp;
+  }
+}
+
+wxString ElisionCell::ToString(bool all)
+{
+  wxString text;
+  MathCell *cells = Expand();
+  if (cells != NULL)
+    text = cells->ToString(true);
+  DestroyCells(cells);
+  return text + MathCell::ToString(all);
+}
+
+wxString ElisionCell::ToTeX(bool all)
+{
+  wxString text;
+  MathCell *cells = Expand();
+  if (cells != NULL)
+    text = cells->ToTeX(true);
+  DestroyCells(cells);
+  return text + MathCell::ToTeX(all);
+}
+
+wxString ElisionCell::ToXML(bool all)
+{
+  return m_hidden + MathCell::ToXML(all);
+}
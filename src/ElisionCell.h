@@ -0,0 +1,50 @@
+///
+///  Copyright (C) 2004-2011 Andrej Vodopivec <andrej.vodopivec@gmail.com>
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///
+///  You should have received a copy of the GNU General Public License
+///  along with this program; if not, write to the Free Software
+///  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+///
+
+
+#ifndef _ELISIONCELL_H_
+#define _ELISIONCELL_H_
+
+#include "TextCell.h"
+
+/***
+ * ElisionCell stands for the middle terms of a result too long to
+ * display, or the middle digits of a very long number. It keeps their xml and shows only how many terms there are.
+ * The cells are made on demand: Expand when the user clicks it, and
+ * temporarily for copying and TeX export. The xml goes unchanged into
+ * saved documents.
+ */
+class ElisionCell : public TextCell
+{
+public:
+  ElisionCell(const wxString& hidden, int terms, bool digits = false);
+  MathCell* Copy(bool all);
+  MathCell* Expand();
+  int GetTerms() { return m_terms; }
+  wxString ToString(bool all);
+  wxString ToTeX(bool all);
+  wxString ToXML(bool all);
+private:
+  static void DestroyCells(MathCell *cells);
+  wxString m_hidden;  // xml of the hidden terms
+  int m_terms;
+  bool m_digits;      // the terms are digits of a number
+};
+
+#endif //_ELISIONCELL_H_
@@ -34,13 +34,7 @@ EvaluationQueue::EvaluationQueue()
 
 bool EvaluationQueue::IsInQueue(GroupCell* gr)
 {
-  EvaluationQueueElement* tmp = m_queue;
-  while (tmp != NULL) {
-    if (tmp->group == gr)
-      return true;
-    tmp = tmp->next;
-  }
-  return false;
+  return m_groups.find(gr) != m_groups.end();
 }
 
 void EvaluationQueue::AddToQueue(GroupCell* gr)
@@ -49,6 +43,7 @@ void EvaluationQueue::AddToQueue(GroupCell* gr)
       || gr->GetEditable() == NULL) // dont add cells which can't be evaluated
     return;
   EvaluationQueueElement* newelement = new EvaluationQueueElement(gr);
+  m_groups[gr]++;
   if (m_last == NULL)
     m_queue = m_last = newelement;
   else {
@@ -85,6 +80,9 @@ void EvaluationQueue::RemoveFirst()
   else
     m_queue = m_queue->next;
 
+  if (--m_groups[tmp->group] == 0)
+    m_groups.erase(tmp->group);
+
   delete tmp;
 }
 
@@ -24,6 +24,11 @@
 
 #include "GroupCell.h"
 
+#include <wx/hashmap.h>
+
+// how often each group is in the queue
+WX_DECLARE_HASH_MAP(GroupCell*, int, wxPointerHash, wxPointerEqual, GroupCellCount);
+
 class EvaluationQueueElement {
   public:
     EvaluationQueueElement(GroupCell* gr);
@@ -50,6 +55,7 @@ class EvaluationQueue
   private:
     EvaluationQueueElement* m_queue;
     EvaluationQueueElement* m_last;
+    GroupCellCount m_groups; // for IsInQueue, which is called for every group on paint
 };
 
 
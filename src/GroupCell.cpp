@@ -26,6 +26,7 @@
 #include "TextCell.h"
 #include "EditorCell.h"
 #include "ImgCell.h"
+#include "PlainTextCell.h"
 #include "Bitmap.h"
 
 GroupCell::GroupCell(int groupType, wxString initString) : MathCell()
@@ -48,6 +49,16 @@ GroupCell::GroupCell(int groupType, wxString initString) : MathCell()
   m_groupType = groupType;
   m_lastInOutput = NULL;
   m_appendedCells = NULL;
+  m_grownCell = NULL;
+  m_grownHeight = 0;
+  m_outputLines = 0;
+  m_droppedLines = 0;
+  m_droppedNote = NULL;
+  m_clientWidth = -1;
+  m_layoutPending = false;
+  m_evaluationTime = -1;
+  m_displayTime = 0;
+  m_outputMode = GC_OUTPUT_DEFAULT;
 
   // set up cell depending on groupType, so we have a working cell
   if (groupType != GC_TYPE_PAGEBREAK) {
@@ -171,6 +182,9 @@ MathCell* GroupCell::Copy(bool all)
 {
   GroupCell* tmp = new GroupCell(m_groupType);
   tmp->Hide(m_hide);
+  tmp->SetEvaluationTime(m_evaluationTime);
+  tmp->AddDisplayTime(GetDisplayTime());
+  tmp->SetOutputMode(m_outputMode);
   CopyData(this, tmp);
   if (m_input)
     tmp->SetInput(m_input->Copy(true));
@@ -232,12 +246,15 @@ void GroupCell::SetOutput(MathCell *output)
 
   m_output = output;
   m_output->m_group = this;
+  m_breakCache.clear();
 
   m_lastInOutput = m_output;
 
   while (m_lastInOutput->m_next != NULL)
     m_lastInOutput = m_lastInOutput->m_next;
 
+  m_outputLines = CountLines(m_output);
+
   //m_appendedCells = output;
 }
 
@@ -248,9 +265,31 @@ void GroupCell::RemoveOutput()
   m_output = NULL;
   m_lastInOutput = NULL;
   m_appendedCells = NULL;
+  m_grownCell = NULL;
+  m_outputLines = 0;
+  m_droppedLines = 0;
+  m_droppedNote = NULL;
+  m_breakCache.clear();
   m_hide = false;
 }
 
+/***
+ * The number of output lines in the list from cell up to stop.
+ */
+int GroupCell::CountLines(MathCell *cell, MathCell *stop)
+{
+  int lines = 0;
+  for (MathCell *tmp = cell; tmp != stop; tmp = tmp->m_next)
+  {
+    PlainTextCell *text = dynamic_cast<PlainTextCell*>(tmp);
+    if (text != NULL)
+      lines += text->GetLineCount();
+    else if (tmp == cell || tmp->ForceBreakLineHere())
+      lines++;
+  }
+  return lines;
+}
+
 void GroupCell::AppendOutput(MathCell *cell)
 {
   if (m_output == NULL) {
@@ -282,6 +321,295 @@ void GroupCell::AppendOutput(MathCell *cell)
 
   if (m_appendedCells == NULL)
     m_appendedCells = cell;
+
+  m_outputLines += CountLines(cell);
+  m_breakCache.clear();
+}
+
+/***
+ * Replace the top level output cell by the list replacement and delete
+ * it. The output has to be laid out again afterwards.
+ */
+bool GroupCell::ReplaceOutputCell(MathCell *cell, MathCell *replacement)
+{
+  return ReplaceOutputCells(cell, cell, replacement);
+}
+
+/***
+ * Replace the top level output cells from first to last by the list
+ * replacement and delete them.
+ */
+bool GroupCell::ReplaceOutputCells(MathCell *first, MathCell *last, MathCell *replacement)
+{
+  MathCell *tmp = m_output;
+  while (tmp != NULL && tmp != first)
+    tmp = tmp->m_next;
+  while (tmp != NULL && tmp != last)
+    tmp = tmp->m_next;
+  if (tmp == NULL || replacement == NULL)
+    return false;
+
+  UnBreakUpCells();
+
+  MathCell *end = replacement;
+  while (end->m_next != NULL)
+    end = end->m_next;
+
+  MathCell *previous = first->m_previous, *next = last->m_next;
+  if (previous != NULL)
+    previous->m_next = previous->m_nextToDraw = replacement;
+  else
+    m_output = replacement;
+  replacement->m_previous = replacement->m_previousToDraw = previous;
+  end->m_next = end->m_nextToDraw = next;
+  if (next != NULL)
+    next->m_previous = next->m_previousToDraw = end;
+
+  last->m_next = last->m_nextToDraw = NULL;
+  for (tmp = first; tmp != NULL; tmp = tmp->m_next)
+  {
+    if (m_lastInOutput == tmp)
+      m_lastInOutput = end;
+    if (m_appendedCells == tmp)
+      m_appendedCells = replacement;
+  }
+
+  for (tmp = replacement; tmp != next; tmp = tmp->m_next)
+    tmp->SetParent(this, false);
+
+  while (first != NULL)
+  {
+    tmp = first;
+    first = first->m_next;
+    if (m_droppedNote == tmp)
+      m_droppedNote = NULL;
+    tmp->Destroy();
+    delete tmp;
+  }
+
+  m_grownCell = NULL;
+  m_outputLines = CountLines(m_output);
+  m_breakCache.clear();
+  ResetSize();
+  return true;
+}
+
+/***
+ * Replace cell, which is inside another output cell, by the list
+ * replacement and delete it. The digits of a long number are elided
+ * wherever the number is, in a fraction, an exponent or an argument, but
+ * never in the first cell of a list, so the list keeps its head.
+ */
+bool GroupCell::ReplaceInnerCell(MathCell *cell, MathCell *replacement)
+{
+  MathCell *previous = cell->m_previous;
+  if (previous == NULL || previous->m_next != cell || replacement == NULL)
+    return false;
+
+  UnBreakUpCells();
+
+  MathCell *end = replacement;
+  while (end->m_next != NULL)
+    end = end->m_next;
+
+  MathCell *next = cell->m_next;
+  previous->m_next = previous->m_nextToDraw = replacement;
+  replacement->m_previous = replacement->m_previousToDraw = previous;
+  end->m_next = end->m_nextToDraw = next;
+  if (next != NULL)
+    next->m_previous = next->m_previousToDraw = end;
+
+  for (MathCell *tmp = replacement; tmp != next; tmp = tmp->m_next)
+    tmp->SetParent(this, false);
+
+  cell->m_next = cell->m_nextToDraw = NULL;
+  cell->Destroy();
+  delete cell;
+
+  m_breakCache.clear();
+  ResetSize();
+  return true;
+}
+
+/***
+ * The output cell got lines more after it was laid out. The group only
+ * adds the height of the new lines in RecalculateAppended.
+ */
+void GroupCell::OutputGrown(MathCell *cell, int lines)
+{
+  m_outputLines += lines;
+  if (m_appendedCells != NULL || m_grownCell != NULL)
+    return;
+  m_grownCell = cell;
+  m_grownHeight = cell->GetMaxHeight();
+}
+
+/***
+ * Remove the oldest output lines if there are more than maxLines. A
+ * note at the start of the output tells how many lines were removed.
+ * Lines are removed down to 3/4 of maxLines, so that a long running
+ * computation doesn't lay out the group again for every line.
+ */
+bool GroupCell::LimitOutput(int maxLines)
+{
+  if (m_outputLines <= maxLines || m_output == NULL)
+    return false;
+
+  UnBreakUpCells();
+
+  int drop = m_outputLines - maxLines * 3 / 4;
+  MathCell *first = m_output;
+  if (first == m_droppedNote)
+    first = first->m_next;
+
+  while (first != NULL && drop > 0)
+  {
+    PlainTextCell *text = dynamic_cast<PlainTextCell*>(first);
+    if (text != NULL && int(text->GetLineCount()) > drop)
+    {
+      text->RemoveLines(drop);
+      m_droppedLines += drop;
+      m_outputLines -= drop;
+      break;
+    }
+
+    // the line which starts at first
+    MathCell *end = first;
+    while (end->m_next != NULL && !end->m_next->ForceBreakLineHere())
+      end = end->m_next;
+    if (end->m_next == NULL)
+      break; // keep the last line
+    MathCell *next = end->m_next;
+    int lines = CountLines(first, next);
+
+    if (first->m_previous != NULL)
+      first->m_previous->m_next = first->m_previous->m_nextToDraw = next;
+    else
+      m_output = next;
+    next->m_previous = next->m_previousToDraw = first->m_previous;
+    end->m_next = end->m_nextToDraw = NULL;
+    while (first != NULL)
+    {
+      MathCell *tmp = first;
+      first = first->m_next;
+      tmp->Destroy();
+      delete tmp;
+    }
+
+    first = next;
+    m_droppedLines += lines;
+    m_outputLines -= lines;
+    drop -= lines;
+  }
+
+  wxString note = wxString::Format(_("[%d earlier lines of output were removed]"),
+                                   m_droppedLines);
+  if (m_droppedNote == NULL)
+  {
+    m_droppedNote = new TextCell(note);
+    m_droppedNote->SetParent(this, false);
+    m_droppedNote->ForceBreakLine(true);
+    m_output->ForceBreakLine(true);
+    m_droppedNote->m_next = m_droppedNote->m_nextToDraw = m_output;
+    m_output->m_previous = m_output->m_previousToDraw = m_droppedNote;
+    m_output = m_droppedNote;
+    m_outputLines++;
+  }
+  else
+    m_droppedNote->SetValue(note);
+
+  m_output->m_group = this;
+  m_appendedCells = NULL;
+  m_grownCell = NULL;
+  m_breakCache.clear();
+  ResetSize();
+  return true;
+}
+
+/***
+ * Show the output lines which consist only of text and math as plain
+ * text. Images and prompts stay as they are.
+ */
+void GroupCell::OutputToText()
+{
+  UnBreakUpCells();
+
+  MathCell *line = m_output;
+  while (line != NULL)
+  {
+    MathCell *end = line;
+    bool text = line->GetType() == MC_TYPE_DEFAULT || line->GetType() == MC_TYPE_LABEL;
+    while (end->m_next != NULL && !end->m_next->ForceBreakLineHere())
+    {
+      end = end->m_next;
+      if (end->GetType() != MC_TYPE_DEFAULT && end->GetType() != MC_TYPE_LABEL)
+        text = false;
+    }
+    for (MathCell *tmp = line; text && tmp != end->m_next; tmp = tmp->m_next)
+      if (dynamic_cast<PlainTextCell*>(tmp) != NULL)
+        text = false;
+
+    MathCell *next = end->m_next;
+    if (text)
+    {
+      wxString str, xml;
+      for (MathCell *tmp = line; tmp != next; tmp = tmp->m_next)
+      {
+        str += tmp->ToString(false);
+        xml += tmp->ToXML(false);
+      }
+
+      // continue the text of the line before if there is one
+      PlainTextCell *cell = dynamic_cast<PlainTextCell*>(line->m_previous);
+      if (cell != NULL && cell->GetType() == MC_TYPE_DEFAULT)
+      {
+        cell->AppendLine(str, xml);
+        cell->m_next = cell->m_nextToDraw = next;
+        if (next != NULL)
+          next->m_previous = next->m_previousToDraw = cell;
+        if (m_lastInOutput == end)
+          m_lastInOutput = cell;
+        end->m_next = NULL;
+        while (line != NULL)
+        {
+          MathCell *tmp = line;
+          line = line->m_next;
+          if (m_appendedCells == tmp)
+            m_appendedCells = cell;
+          tmp->Destroy();
+          delete tmp;
+        }
+      }
+      else
+      {
+        cell = new PlainTextCell;
+        cell->SetType(MC_TYPE_DEFAULT);
+        cell->AppendLine(str, xml);
+        cell->ForceBreakLine(true);
+        ReplaceOutputCells(line, end, cell);
+      }
+    }
+    line = next;
+  }
+
+  m_breakCache.clear();
+  ResetSize();
+}
+
+/***
+ * Show the plain text output as 2D math again.
+ */
+void GroupCell::OutputToMath()
+{
+  MathCell *tmp = m_output;
+  while (tmp != NULL)
+  {
+    MathCell *next = tmp->m_next;
+    PlainTextCell *cell = dynamic_cast<PlainTextCell*>(tmp);
+    if (cell != NULL)
+      ReplaceOutputCell(cell, cell->ToCells());
+    tmp = next;
+  }
 }
 
 void GroupCell::Recalculate(CellParser& parser, int d_fontsize, int m_fontsize)
@@ -329,9 +657,11 @@ void GroupCell::RecalculateWidths(CellParser& parser, int fontsize, bool all)
       m_width = m_input->GetFullWidth(scale);
     }
 
-    BreakUpCells(parser, m_fontSize, parser.GetClientWidth());
-    BreakLines(parser.GetClientWidth());
+    m_breakCache.clear();
+    BreakAndCache(parser);
   }
+  else if (NeedsReflow(parser.GetClientWidth()))
+    Reflow(parser);
   MathCell::RecalculateWidths(parser, m_fontSize, all);
 }
 
@@ -382,6 +712,9 @@ void GroupCell::RecalculateSize(CellParser& parser, int fontsize, bool all)
         tmp = tmp->m_nextToDraw;
       }
     }
+    // the output appended since the last layout is included now
+    m_appendedCells = NULL;
+    m_grownCell = NULL;
   }
 
   MathCell::RecalculateSize(parser, fontsize, all);
@@ -390,12 +723,38 @@ void GroupCell::RecalculateSize(CellParser& parser, int fontsize, bool all)
 // We assume that appended cells will be in a new line!
 void GroupCell::RecalculateAppended(CellParser& parser)
 {
+  if (m_appendedCells == NULL && m_grownCell == NULL)
+    return;
+
+  // not laid out yet: the full layout includes the new output
+  if (m_width == -1 || m_height == -1)
+  {
+    m_appendedCells = NULL;
+    m_grownCell = NULL;
+    return;
+  }
+
+  double scale = parser.GetScale();
+
+  // The grown cell is on the last line, add the height of its new lines.
+  if (m_grownCell != NULL)
+  {
+    MathCell *cell = m_grownCell;
+    int fontsize = cell->IsMath() ? m_mathFontSize : m_fontSize;
+    cell->RecalculateWidths(parser, fontsize, false);
+    cell->RecalculateSize(parser, fontsize, false);
+    m_height += cell->GetMaxHeight() - m_grownHeight;
+    m_outputRect.height += cell->GetMaxHeight() - m_grownHeight;
+    m_width = MAX(m_width, cell->GetLineWidth(scale));
+    m_outputRect.width = MAX(m_outputRect.width, cell->GetLineWidth(scale));
+    m_grownCell = NULL;
+  }
+
   if (m_appendedCells == NULL)
     return;
 
   MathCell *tmp = m_appendedCells;
   int fontsize = m_fontSize;
-  double scale = parser.GetScale();
 
   // Recalculate widths of cells
   while (tmp != NULL) {
@@ -764,9 +1123,23 @@ wxString GroupCell::ToTeX(bool all, wxString imgDir, wxString filename, int *img
   return str + MathCell::ToTeX(all);
 }
 
+/***
+ * The evaluation time as shown in the tooltip of the bracket.
+ */
+wxString GroupCell::GetTimingText()
+{
+  if (m_evaluationTime < 0)
+    return wxEmptyString;
+
+  return wxString::Format(_("Evaluation: %.3f s (Maxima %.3f s, wxMaxima %.3f s)"),
+                          m_evaluationTime / 1000.0,
+                          MAX(m_evaluationTime - GetDisplayTime(), 0) / 1000.0,
+                          GetDisplayTime() / 1000.0);
+}
+
 // ToXML
 // writes a groupcell in the form of
-// <cell type="code" hide="true">
+// <cell type="code" hide="true" evaltime="1200" displaytime="40">
 // --contents--
 // </cell>
 wxString GroupCell::ToXML(bool all)
@@ -807,6 +1180,10 @@ wxString GroupCell::ToXML(bool all)
   // write hidden status
   if (m_hide)
     str += wxT(" hide=\"true\"");
+  // write evaluation timing
+  if (m_evaluationTime >= 0)
+    str += wxString::Format(wxT(" evaltime=\"%ld\" displaytime=\"%ld\""),
+                            m_evaluationTime, GetDisplayTime());
   str += wxT(">\n");
 
   MathCell *input = GetInput();
@@ -1000,22 +1377,26 @@ void GroupCell::BreakLines(int fullWidth)
   BreakLines(m_output, fullWidth);
 }
 
-void GroupCell::BreakLines(MathCell *cell, int fullWidth)
+void GroupCell::BreakLines(MathCell *cell, int fullWidth, std::vector<bool> *lineBreaks)
 {
   int currentWidth = m_indent;
 
   MathCell *tmp = cell;
 
   while (tmp != NULL && !m_hide) {
+    bool breakLine = false;
     tmp->ResetData();
     tmp->BreakLine(false);
     if (!tmp->m_isBroken) {
       if (tmp->BreakLineHere() || (currentWidth + tmp->GetWidth() >= fullWidth)) {
         currentWidth = m_indent + tmp->GetWidth();
         tmp->BreakLine(true);
+        breakLine = true;
       } else
         currentWidth += (tmp->GetWidth() + MC_CELL_SKIP);
     }
+    if (lineBreaks != NULL)
+      lineBreaks->push_back(breakLine);
     tmp = tmp->m_nextToDraw;
   }
 }
@@ -1049,17 +1430,22 @@ void GroupCell::BreakUpCells(CellParser parser, int fontsize, int clientWidth)
   BreakUpCells(m_output, parser, fontsize, clientWidth);
 }
 
-void GroupCell::BreakUpCells(MathCell *cell, CellParser parser, int fontsize, int clientWidth)
+void GroupCell::BreakUpCells(MathCell *cell, CellParser parser, int fontsize, int clientWidth,
+                             std::vector<bool> *breakUps)
 {
   MathCell *tmp = cell;
 
   while (tmp != NULL && !m_hide) {
+    bool brokenUp = false;
     if (tmp->GetWidth() > clientWidth) {
       if (tmp->BreakUp()) {
         tmp->RecalculateWidths(parser,  tmp->IsMath() ? m_mathFontSize : m_fontSize, false);
         tmp->RecalculateSize(parser,  tmp->IsMath() ? m_mathFontSize : m_fontSize, false);
+        brokenUp = true;
       }
     }
+    if (breakUps != NULL)
+      breakUps->push_back(brokenUp);
     tmp = tmp->m_nextToDraw;
   }
 }
@@ -1075,6 +1461,94 @@ void GroupCell::UnBreakUpCells()
   }
 }
 
+/***
+ * Break up cells and lines for the current client width and remember
+ * the decisions, so that returning to this width doesn't need them again.
+ */
+void GroupCell::BreakAndCache(CellParser& parser)
+{
+  BreakCacheEntry entry;
+  entry.clientWidth = parser.GetClientWidth();
+
+  BreakUpCells(m_output, parser, m_fontSize, entry.clientWidth, &entry.breakUps);
+  BreakLines(m_output, entry.clientWidth, &entry.lineBreaks);
+  m_clientWidth = entry.clientWidth;
+
+  m_breakCache.insert(m_breakCache.begin(), entry);
+  if (m_breakCache.size() > GC_BREAK_CACHE_SIZE)
+    m_breakCache.pop_back();
+}
+
+/***
+ * Apply cached break decisions. BreakUpCells visits cells in an order
+ * which depends only on earlier decisions, so replaying them in the same
+ * order gives the same result.
+ */
+void GroupCell::ReplayBreaks(CellParser& parser, BreakCacheEntry& entry)
+{
+  MathCell *tmp = m_output;
+  size_t i = 0;
+  while (tmp != NULL && i < entry.breakUps.size()) {
+    if (entry.breakUps[i++] && tmp->BreakUp()) {
+      tmp->RecalculateWidths(parser,  tmp->IsMath() ? m_mathFontSize : m_fontSize, false);
+      tmp->RecalculateSize(parser,  tmp->IsMath() ? m_mathFontSize : m_fontSize, false);
+    }
+    tmp = tmp->m_nextToDraw;
+  }
+
+  tmp = m_output;
+  i = 0;
+  while (tmp != NULL && i < entry.lineBreaks.size()) {
+    tmp->ResetData();
+    tmp->BreakLine(entry.lineBreaks[i++]);
+    tmp = tmp->m_nextToDraw;
+  }
+
+  m_clientWidth = entry.clientWidth;
+}
+
+/***
+ * Redo line breaking for a new client width. Only the cells which were
+ * broken up are measured again, since their sizes changed with BreakUp;
+ * the breaks are taken from the cache or computed from the known widths.
+ */
+void GroupCell::Reflow(CellParser& parser)
+{
+  int clientWidth = parser.GetClientWidth();
+
+  if (m_groupType == GC_TYPE_PAGEBREAK || m_output == NULL || m_hide) {
+    m_clientWidth = clientWidth;
+    return;
+  }
+
+  // unbroken cells get back the sizes they have in one piece
+  MathCell *tmp = m_output;
+  while (tmp != NULL) {
+    if (tmp->m_isBroken) {
+      tmp->Unbreak(false);
+      tmp->RecalculateWidths(parser, tmp->IsMath() ? m_mathFontSize : m_fontSize, false);
+      tmp->RecalculateSize(parser, tmp->IsMath() ? m_mathFontSize : m_fontSize, false);
+    }
+    tmp = tmp->m_next;
+  }
+
+  std::vector<BreakCacheEntry>::iterator it = m_breakCache.begin();
+  while (it != m_breakCache.end() && it->clientWidth != clientWidth)
+    ++it;
+
+  if (it != m_breakCache.end()) {
+    BreakCacheEntry entry = *it;
+    m_breakCache.erase(it);
+    m_breakCache.insert(m_breakCache.begin(), entry);
+    ReplayBreaks(parser, m_breakCache.front());
+  }
+  else
+    BreakAndCache(parser);
+
+  // RecalculateSize updates the height and the output rectangle
+  m_height = -1;
+}
+
 // support for hiding text, code cells
 
 void GroupCell::Hide(bool hide) {
@@ -1098,6 +1572,7 @@ void GroupCell::Hide(bool hide) {
 
     ResetSize();
     GetEditable()->ResetSize();
+    m_breakCache.clear();
   }
 }
 
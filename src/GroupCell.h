@@ -24,7 +24,10 @@
 #include "MathCell.h"
 #include "EditorCell.h"
 
+#include <vector>
+
 #define EMPTY_INPUT_LABEL wxT("-->  ")
+#define GC_BREAK_CACHE_SIZE 4
 
 enum
 {
@@ -37,6 +40,22 @@ enum
   GC_TYPE_PAGEBREAK
 };
 
+// How the output of a group is shown
+enum
+{
+  GC_OUTPUT_DEFAULT, // as set in the configuration
+  GC_OUTPUT_MATH,
+  GC_OUTPUT_TEXT
+};
+
+// Line break decisions of a group for one client width
+struct BreakCacheEntry
+{
+  int clientWidth;
+  std::vector<bool> breakUps;   // results of BreakUp in BreakUpCells order
+  std::vector<bool> lineBreaks; // line breaks in BreakLines order
+};
+
 class GroupCell: public MathCell
 {
 public:
@@ -59,6 +78,19 @@ public:
   EditorCell* GetEditable(); // returns pointer to editor (if there is one)
   void AppendOutput(MathCell *cell);
   void RemoveOutput();
+  bool ReplaceOutputCell(MathCell *cell, MathCell *replacement);
+  bool ReplaceOutputCells(MathCell *first, MathCell *last, MathCell *replacement);
+  bool ReplaceInnerCell(MathCell *cell, MathCell *replacement);
+  MathCell* GetLastOutput() { return m_lastInOutput; }
+  void OutputGrown(MathCell *cell, int lines);
+  bool HasPendingOutput() { return m_appendedCells != NULL || m_grownCell != NULL; }
+  int GetOutputLines() { return m_outputLines; }
+  bool LimitOutput(int maxLines);
+  // plain text output
+  int GetOutputMode() { return m_outputMode; }
+  void SetOutputMode(int mode) { m_outputMode = mode; }
+  void OutputToText();
+  void OutputToMath();
   // exporting
   wxString ToTeX(bool all, wxString imgDir, wxString filename, int *imgCounter);
   wxString ToTeX(bool all);
@@ -83,10 +115,22 @@ public:
   void RecalculateWidths(CellParser& parser, int fontsize, bool all);
   void Recalculate(CellParser& parser, int d_fontsize, int m_fontsize);
   void BreakUpCells(CellParser parser, int fontsize, int clientWidth);
-  void BreakUpCells(MathCell *cell, CellParser parser, int fontsize, int clientWidth);
+  void BreakUpCells(MathCell *cell, CellParser parser, int fontsize, int clientWidth,
+                    std::vector<bool> *breakUps = NULL);
   void UnBreakUpCells();
   void BreakLines(int fullWidth);
-  void BreakLines(MathCell *cell, int fullWidth);
+  void BreakLines(MathCell *cell, int fullWidth, std::vector<bool> *lineBreaks = NULL);
+  void Reflow(CellParser& parser);
+  bool NeedsReflow(int clientWidth) { return m_clientWidth != clientWidth; }
+  void SetLayoutPending(bool pending) { m_layoutPending = pending; }
+  bool IsLayoutPending() { return m_layoutPending; }
+  // evaluation timing, in ms, -1 if the group was not evaluated
+  void SetEvaluationTime(long time) { m_evaluationTime = time; }
+  long GetEvaluationTime() { return m_evaluationTime; }
+  void ResetDisplayTime() { m_displayTime = 0; }
+  void AddDisplayTime(double time) { m_displayTime += time; }
+  long GetDisplayTime() { return long(m_displayTime + 0.5); }
+  wxString GetTimingText();
   void ResetInputLabel(bool all = false); // if !all only this GC is reset
   // folding and unfolding
   bool IsFoldable() { return ((m_groupType == GC_TYPE_SECTION) ||
@@ -119,7 +163,21 @@ protected:
   int m_mathFontSize;
   MathCell *m_lastInOutput;
   MathCell *m_appendedCells;
+  MathCell *m_grownCell;  // output cell which got lines after its layout
+  int m_grownHeight;      // and its height at the layout
+  int m_outputLines;
+  int m_droppedLines;     // removed by LimitOutput
+  MathCell *m_droppedNote;
+  static int CountLines(MathCell *cell, MathCell *stop = NULL);
   wxRect m_outputRect;
+  int m_clientWidth; // client width of the last line breaking
+  bool m_layoutPending; // waiting for MathCtrl to recalculate it
+  long m_evaluationTime; // from sending the input to the next prompt
+  double m_displayTime;  // of that, parsing and layout of the output
+  int m_outputMode;
+  std::vector<BreakCacheEntry> m_breakCache; // most recently used first
+  void BreakAndCache(CellParser& parser);
+  void ReplayBreaks(CellParser& parser, BreakCacheEntry& entry);
   wxString ToString(bool all);
 };
 
@@ -20,7 +20,6 @@
 #include "History.h"
 
 #include <wx/sizer.h>
-#include <wx/tokenzr.h>
 #include <wx/regex.h>
 
 History::History(wxWindow* parent, int id) : wxPanel(parent, id)
@@ -45,21 +44,13 @@ History::~History()
   //TODO: Load/save history?
 }
 
-void History::AddToHistory(wxString cmd)
+/***
+ * Add the statements of an input, as split by MaximaInput.
+ */
+void History::AddToHistory(const wxArrayString& statements)
 {
-  wxString lineends = wxT(";$");
-  if (cmd.StartsWith(wxT(":lisp")))
-    lineends = wxT(";");
-
-  wxStringTokenizer cmds(cmd, lineends);
-
-  while (cmds.HasMoreTokens())
-  {
-    wxString curr = cmds.GetNextToken().Trim(false).Trim(true);
-
-    if (curr != wxEmptyString)
-      commands.Insert(curr, 0);
-  }
+  for (size_t i = 0; i < statements.GetCount(); i++)
+    commands.Insert(statements[i], 0);
 
   m_current = commands.GetCount();
 
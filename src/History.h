@@ -32,7 +32,7 @@ class History : public wxPanel
 public:
   History(wxWindow* parent, int id);
   ~History();
-  void AddToHistory(wxString cmd);
+  void AddToHistory(const wxArrayString& statements);
   void OnRegExEvent(wxCommandEvent &ev);
   void UpdateDisplay();
   wxString GetCommand(bool next);
@@ -22,6 +22,7 @@
 
 #include "wxMaxima.h"
 #include "MathCtrl.h"
+#include "Profiler.h"
 #include "Bitmap.h"
 #include "Setup.h"
 #include "EditorCell.h"
@@ -40,11 +41,15 @@
 #include <wx/txtstrm.h>
 #include <wx/filesys.h>
 #include <wx/fs_mem.h>
+#include <wx/stopwatch.h>
 
 #define SCROLL_UNIT 10
 #define CARET_TIMER_TIMEOUT 500
 #define ANIMATION_TIMER_TIMEOUT 300
+#define LAYOUT_IDLE_BUDGET 20 // ms of layout work per idle event
 #define AC_MENU_LENGTH 25
+#define OUTPUT_INTERVAL 16 // ms between layouts of new output
+#define MC_MAX_OUTPUT_LINES 100000 // output lines kept in one group
 
 void AddLineToFile(wxTextFile& output, wxString s, bool unicode = true);
 
@@ -52,7 +57,8 @@ enum
 {
   TIMER_ID,
   CARET_TIMER_ID,
-  ANIMATION_TIMER_ID
+  ANIMATION_TIMER_ID,
+  OUTPUT_TIMER_ID
 };
 
 MathCtrl::MathCtrl(wxWindow* parent, int id, wxPoint position, wxSize size) :
@@ -83,10 +89,14 @@ MathCtrl::MathCtrl(wxWindow* parent, int id, wxPoint position, wxSize size) :
   m_timer.SetOwner(this, TIMER_ID);
   m_caretTimer.SetOwner(this, CARET_TIMER_ID);
   m_animationTimer.SetOwner(this, ANIMATION_TIMER_ID);
+  m_outputTimer.SetOwner(this, OUTPUT_TIMER_ID);
+  m_outputPending = false;
   m_animate = false;
   m_workingGroup = NULL;
   m_saved = true;
   m_zoomFactor = 1.0; // set zoom to 100%
+  m_layoutPending = false;
+  m_layoutForce = false;
   m_evaluationQueue = new EvaluationQueue();
   AdjustSize();
 
@@ -107,6 +117,7 @@ MathCtrl::~MathCtrl() {
  * Redraw the control
  */
 void MathCtrl::OnPaint(wxPaintEvent& event) {
+  PROFILE_SCOPE("OnPaint");
   wxPaintDC dc(this);
 
   wxMemoryDC dcm;
@@ -118,9 +129,9 @@ void MathCtrl::OnPaint(wxPaintEvent& event) {
   wxRect rect = GetUpdateRegion().GetBox();
   //printf("Updating rect [%d, %d] -> [%d, %d]\n", rect.x, rect.y, rect.width, rect.height);
   wxSize sz = GetSize();
-  int tmp, top, bottom, drop;
-  CalcUnscrolledPosition(0, rect.GetTop(), &tmp, &top);
-  CalcUnscrolledPosition(0, rect.GetBottom(), &tmp, &bottom);
+  int top, bottom, left, right, drop;
+  CalcUnscrolledPosition(rect.GetLeft(), rect.GetTop(), &left, &top);
+  CalcUnscrolledPosition(rect.GetRight(), rect.GetBottom(), &right, &bottom);
 
   // Thest if m_memory is NULL (resize event)
   if (m_memory == NULL)
@@ -141,9 +152,25 @@ void MathCtrl::OnPaint(wxPaintEvent& event) {
 
   CellParser parser(dcm);
   parser.SetBounds(top, bottom);
+  parser.SetHorizontalBounds(left, right);
+  int visibleLeft, visibleTop;
+  CalcUnscrolledPosition(0, 0, &visibleLeft, &visibleTop);
+  parser.SetVisibleRegion(wxRect(wxPoint(visibleLeft, visibleTop), GetClientSize()));
   parser.SetZoomFactor(m_zoomFactor);
   int fontsize = parser.GetDefaultFontSize(); // apply zoomfactor to defaultfontsize
 
+  // Groups scrolled into view before OnIdle got to them
+  RecalculateVisible();
+
+  // Output which came in since the last layout, FlushOutput scrolls to it
+  if (m_outputPending)
+  {
+    GroupCell *group = (m_workingGroup != NULL) ? m_workingGroup : m_last;
+    parser.SetClientWidth(GetClientSize().GetWidth() - MC_GROUP_LEFT_INDENT - MC_BASE_INDENT);
+    if (group != NULL)
+      group->RecalculateAppended(parser);
+  }
+
   // Draw content
   if (m_tree != NULL)
   {
@@ -342,10 +369,14 @@ GroupCell *MathCtrl::UpdateMLast()
 }
 
 /***
- * Add a new line to working group or m_last
+ * Add a new line to working group or m_last. The layout of new output is
+ * done at most once per OUTPUT_INTERVAL ms in FlushOutput, so that a fast
+ * stream of lines doesn't lay out and repaint the document for each of
+ * them. Prompts are shown at once.
  */
 void MathCtrl::InsertLine(MathCell *newCell, bool forceNewLine)
 {
+  PROFILE_SCOPE("InsertLine");
   SetActiveCell(NULL, false);
 
   m_saved = false;
@@ -358,12 +389,7 @@ void MathCtrl::InsertLine(MathCell *newCell, bool forceNewLine)
   newCell->ForceBreakLine(forceNewLine);
 
   tmp->AppendOutput(newCell);
-  if (newCell->GetType() == MC_TYPE_PROMPT)
-  {
-    m_workingGroup = tmp;
-    ScrollToCell(tmp->GetParent());
-    OpenHCaret();
-  }
+  bool prompt = newCell->GetType() == MC_TYPE_PROMPT;
 
   while (newCell != NULL)
   {
@@ -374,17 +400,124 @@ void MathCtrl::InsertLine(MathCell *newCell, bool forceNewLine)
   m_selectionStart = NULL;
   m_selectionEnd = NULL;
 
-  wxClientDC dc(this);
-  CellParser parser(dc);
-  parser.SetZoomFactor(m_zoomFactor);
-  parser.SetClientWidth(GetClientSize().GetWidth() - MC_GROUP_LEFT_INDENT - MC_BASE_INDENT);
+  m_outputPending = true;
+  if (prompt)
+  {
+    m_workingGroup = tmp;
+    ScrollToCell(tmp->GetParent());
+    OpenHCaret();
+    FlushOutput();
+  }
+  else if (!m_outputTimer.IsRunning())
+    m_outputTimer.Start(OUTPUT_INTERVAL, true);
+}
+
+/***
+ * Lay out the output appended since the last call and scroll to it.
+ * Groups with more than MC_MAX_OUTPUT_LINES lines of output lose the
+ * oldest ones. The time this takes counts as display time of the group.
+ */
+void MathCtrl::FlushOutput()
+{
+  m_outputTimer.Stop();
+  if (!m_outputPending)
+    return;
+  m_outputPending = false;
 
-  tmp->RecalculateAppended(parser);
+  PROFILE_SCOPE("FlushOutput");
+  GroupCell *tmp = m_workingGroup;
+
+  if (tmp == NULL)
+    tmp = m_last;
+  if (tmp == NULL)
+    return;
+
+  // layout is part of the time spent displaying the output of tmp
+  double start = Profiler::Now();
+
+  if (tmp->LimitOutput(MC_MAX_OUTPUT_LINES))
+  {
+    // the selection may have been in the dropped lines
+    m_selectionStart = NULL;
+    m_selectionEnd = NULL;
+  }
   Recalculate();
 
+  tmp->AddDisplayTime(Profiler::Now() - start);
+
   ScrollToCell(tmp); // also refreshes
 }
 
+/***
+ * Add the lines of cell to the output of the working group. They go into
+ * the plain text the output ends with if there is one.
+ */
+void MathCtrl::AppendPlainText(PlainTextCell *cell)
+{
+  GroupCell *tmp = m_workingGroup;
+
+  if (tmp == NULL)
+    tmp = m_last;
+
+  PlainTextCell *last = dynamic_cast<PlainTextCell*>(tmp->GetLastOutput());
+  if (last == NULL || last->GetType() != cell->GetType())
+  {
+    InsertLine(cell, true);
+    return;
+  }
+
+  PROFILE_SCOPE("AppendPlainText");
+  SetActiveCell(NULL, false);
+  m_saved = false;
+
+  tmp->OutputGrown(last, cell->GetLineCount());
+  last->AppendLines(cell);
+  delete cell;
+
+  m_outputPending = true;
+  if (!m_outputTimer.IsRunning())
+    m_outputTimer.Start(OUTPUT_INTERVAL, true);
+}
+
+/***
+ * Is the output of group shown as plain text?
+ */
+bool MathCtrl::IsTextOutput(GroupCell *group)
+{
+  if (group != NULL && group->GetOutputMode() != GC_OUTPUT_DEFAULT)
+    return group->GetOutputMode() == GC_OUTPUT_TEXT;
+
+  bool plainText = false;
+  wxConfig::Get()->Read(wxT("plainTextOutput"), &plainText);
+  return plainText;
+}
+
+/***
+ * Switch the output of the selected group between plain text and 2D math.
+ */
+void MathCtrl::SwitchTextOutput()
+{
+  if (m_selectionStart == NULL || m_selectionStart->GetType() != MC_TYPE_GROUP)
+    return;
+
+  FlushOutput();
+
+  GroupCell *group = dynamic_cast<GroupCell*>(m_selectionStart);
+  if (IsTextOutput(group))
+  {
+    group->SetOutputMode(GC_OUTPUT_MATH);
+    group->OutputToMath();
+  }
+  else
+  {
+    group->SetOutputMode(GC_OUTPUT_TEXT);
+    group->OutputToText();
+  }
+
+  Recalculate(true);
+  Refresh();
+}
+
 /***
  * Recalculate dimensions of cells
  */
@@ -392,26 +525,162 @@ void MathCtrl::RecalculateForce() {
   Recalculate(true);
 }
 
+/***
+ * Groups which were measured before are not measured again unless force
+ * is true; if only the client width changed they just redo line breaking.
+ * This also completes a pass scheduled with ScheduleRecalculate.
+ */
 void MathCtrl::Recalculate(bool force)
 {
+  PROFILE_SCOPE("Recalculate");
   GroupCell *tmp = m_tree;
 
   wxClientDC dc(this);
   CellParser parser(dc);
   parser.SetZoomFactor(m_zoomFactor);
-  parser.SetForceUpdate(force);
   parser.SetClientWidth(GetClientSize().GetWidth() - MC_GROUP_LEFT_INDENT - MC_BASE_INDENT);
-  int d_fontsize = parser.GetDefaultFontSize();
-  int m_fontsize = parser.GetMathFontSize();
 
   wxPoint point;
   point.x = MC_GROUP_LEFT_INDENT;
   point.y = MC_BASE_INDENT ;
 
   while (tmp != NULL) {
-    tmp->Recalculate(parser, d_fontsize, m_fontsize);
-//    tmp->RecalculateWidths(parser, MAX(fontsize, MC_MIN_SIZE), false);
-//    tmp->RecalculateSize(parser, MAX(fontsize, MC_MIN_SIZE), false);
+    RecalculateGroup(parser, tmp, force);
+    tmp->SetLayoutPending(false);
+    point.y += tmp->GetMaxCenter();
+    tmp->m_currentPoint.x = point.x;
+    tmp->m_currentPoint.y = point.y;
+    point.y += tmp->GetMaxDrop();
+    tmp = dynamic_cast<GroupCell*>(tmp->m_next);
+    point.y += MC_GROUP_SKIP;
+  }
+
+  m_layoutPending = false;
+  m_layoutForce = false;
+
+  AdjustSize();
+}
+
+/***
+ * Recalculate one group. Groups waiting for a scheduled forced pass are
+ * measured again even if force is false.
+ */
+void MathCtrl::RecalculateGroup(CellParser& parser, GroupCell *group, bool force)
+{
+  parser.SetForceUpdate(force || (m_layoutForce && group->IsLayoutPending()));
+  if (!parser.ForceUpdate())
+    group->RecalculateAppended(parser);
+  group->Recalculate(parser, parser.GetDefaultFontSize(), parser.GetMathFontSize());
+  group->SetLayoutPending(false);
+}
+
+/***
+ * Schedule recalculation of the whole document. Groups in the visible part
+ * are recalculated now, the rest in OnIdle a few at a time, so that zooming
+ * or resizing a long document does not block the GUI. Until a group is
+ * recalculated its old size is used as an estimate.
+ */
+void MathCtrl::ScheduleRecalculate(bool force)
+{
+  GroupCell *tmp = m_tree;
+  while (tmp != NULL) {
+    tmp->SetLayoutPending(true);
+    tmp = dynamic_cast<GroupCell*>(tmp->m_next);
+  }
+
+  m_layoutPending = (m_tree != NULL);
+  m_layoutForce = m_layoutPending && (m_layoutForce || force);
+
+  RecalculateVisible();
+  AdjustSize();
+}
+
+/***
+ * Recalculate the pending groups in the visible part of the document and
+ * update the positions of all groups.
+ */
+void MathCtrl::RecalculateVisible()
+{
+  if (!m_layoutPending)
+    return;
+
+  PROFILE_SCOPE("RecalculateVisible");
+
+  GroupCell *tmp = m_tree;
+
+  wxClientDC dc(this);
+  CellParser parser(dc);
+  parser.SetZoomFactor(m_zoomFactor);
+  parser.SetClientWidth(GetClientSize().GetWidth() - MC_GROUP_LEFT_INDENT - MC_BASE_INDENT);
+
+  int x, top, bottom;
+  CalcUnscrolledPosition(0, 0, &x, &top);
+  bottom = top + GetClientSize().GetHeight();
+
+  wxPoint point;
+  point.x = MC_GROUP_LEFT_INDENT;
+  point.y = MC_BASE_INDENT;
+
+  while (tmp != NULL) {
+    if (tmp->IsLayoutPending() && point.y <= bottom &&
+        point.y + tmp->GetMaxHeight() >= top)
+      RecalculateGroup(parser, tmp);
+    point.y += tmp->GetMaxCenter();
+    tmp->m_currentPoint.x = point.x;
+    tmp->m_currentPoint.y = point.y;
+    point.y += tmp->GetMaxDrop();
+    tmp = dynamic_cast<GroupCell*>(tmp->m_next);
+    point.y += MC_GROUP_SKIP;
+  }
+}
+
+/***
+ * Recalculate pending groups for at most LAYOUT_IDLE_BUDGET ms. The group
+ * at the top of the window stays in place while the groups above it
+ * change their heights.
+ */
+void MathCtrl::OnIdle(wxIdleEvent& event)
+{
+  if (!m_layoutPending)
+    return;
+
+  if (m_tree == NULL) {
+    m_layoutPending = m_layoutForce = false;
+    return;
+  }
+
+  PROFILE_SCOPE("IdleLayout");
+  wxStopWatch stopwatch;
+
+  wxClientDC dc(this);
+  CellParser parser(dc);
+  parser.SetZoomFactor(m_zoomFactor);
+  parser.SetClientWidth(GetClientSize().GetWidth() - MC_GROUP_LEFT_INDENT - MC_BASE_INDENT);
+
+  int x, top;
+  CalcUnscrolledPosition(0, 0, &x, &top);
+
+  GroupCell *anchor = m_tree;
+  while (anchor->m_next != NULL &&
+         anchor->m_currentPoint.y + anchor->GetMaxDrop() < top)
+    anchor = dynamic_cast<GroupCell*>(anchor->m_next);
+  int anchorOffset = top - anchor->m_currentPoint.y;
+  int anchorY = anchor->m_currentPoint.y;
+
+  GroupCell *tmp = m_tree;
+  bool done = true;
+
+  wxPoint point;
+  point.x = MC_GROUP_LEFT_INDENT;
+  point.y = MC_BASE_INDENT;
+
+  while (tmp != NULL) {
+    if (tmp->IsLayoutPending()) {
+      if (stopwatch.Time() < LAYOUT_IDLE_BUDGET)
+        RecalculateGroup(parser, tmp);
+      else
+        done = false;
+    }
     point.y += tmp->GetMaxCenter();
     tmp->m_currentPoint.x = point.x;
     tmp->m_currentPoint.y = point.y;
@@ -421,6 +690,17 @@ void MathCtrl::Recalculate(bool force)
   }
 
   AdjustSize();
+
+  if (anchor->m_currentPoint.y != anchorY && top > 0)
+    Scroll(x / SCROLL_UNIT, MAX(anchor->m_currentPoint.y + anchorOffset, 0) / SCROLL_UNIT);
+
+  if (done) {
+    m_layoutPending = false;
+    m_layoutForce = false;
+    Refresh();
+  }
+  else
+    event.RequestMore();
 }
 
 /***
@@ -432,7 +712,7 @@ void MathCtrl::OnSize(wxSizeEvent& event) {
   if (m_tree != NULL) {
     m_selectionStart = NULL;
     m_selectionEnd = NULL;
-    RecalculateForce();
+    ScheduleRecalculate();
   }
   else
     AdjustSize();
@@ -712,6 +992,13 @@ void MathCtrl::OnMouseRightDown(wxMouseEvent& event) {
 
         if (m_selectionStart != m_selectionEnd)
           popupMenu->Append(popid_merge_cells, _("Merge Cells"), wxEmptyString, wxITEM_NORMAL);
+        else if (dynamic_cast<GroupCell*>(m_selectionStart)->GetGroupType() == GC_TYPE_CODE &&
+                 dynamic_cast<GroupCell*>(m_selectionStart)->GetLabel() != NULL) {
+          if (IsTextOutput(dynamic_cast<GroupCell*>(m_selectionStart)))
+            popupMenu->Append(popid_text_output, _("Show Output as 2D Math"), wxEmptyString, wxITEM_NORMAL);
+          else
+            popupMenu->Append(popid_text_output, _("Show Output as Text"), wxEmptyString, wxITEM_NORMAL);
+        }
       }
 
       else {
@@ -890,6 +1177,12 @@ void MathCtrl::OnMouseLeftDown(wxMouseEvent& event) {
             Refresh();
             return;
           }
+          else if ((m_selectionStart == m_selectionEnd) &&
+                   dynamic_cast<ElisionCell*>(m_selectionStart) != NULL) // show the hidden terms
+          {
+            ExpandElision(clickedInGC, dynamic_cast<ElisionCell*>(m_selectionStart));
+            return;
+          }
           else {
             m_clickType = CLICK_TYPE_OUTPUT_SELECTION;
             m_clickInGC = clickedInGC;
@@ -909,6 +1202,29 @@ void MathCtrl::OnMouseLeftDown(wxMouseEvent& event) {
   Refresh();
 }
 
+/***
+ * Replace the elision by the cells of the terms it hides.
+ */
+void MathCtrl::ExpandElision(GroupCell *group, ElisionCell *elision) {
+  m_selectionStart = m_selectionEnd = NULL;
+  m_clickType = CLICK_TYPE_NONE;
+
+  MathCell *cells = elision->Expand();
+  if (group->ReplaceOutputCell(elision, cells) ||
+      group->ReplaceInnerCell(elision, cells))
+    Recalculate(true);
+  else {
+    while (cells != NULL) {
+      MathCell *tmp = cells;
+      cells = cells->m_next;
+      tmp->Destroy();
+      delete tmp;
+    }
+  }
+
+  Refresh();
+}
+
 void MathCtrl::OnMouseLeftUp(wxMouseEvent& event) {
   m_animate = false;
   m_leftDown = false;
@@ -920,6 +1236,8 @@ void MathCtrl::OnMouseLeftUp(wxMouseEvent& event) {
 }
 
 void MathCtrl::OnMouseMotion(wxMouseEvent& event) {
+  if (m_tree != NULL && !m_leftDown)
+    UpdateTimingToolTip(event);
   if (m_tree == NULL || !m_leftDown)
     return;
   m_mouseDrag = true;
@@ -931,6 +1249,31 @@ void MathCtrl::OnMouseMotion(wxMouseEvent& event) {
   ClickNDrag(m_down, m_up);
 }
 
+/***
+ * Show the evaluation time of a group as the tooltip of its bracket.
+ */
+void MathCtrl::UpdateTimingToolTip(wxMouseEvent& event) {
+  wxPoint point;
+  CalcUnscrolledPosition(event.GetX(), event.GetY(), &point.x, &point.y);
+
+  wxString tip;
+  if (point.x < MC_GROUP_LEFT_INDENT) {
+    GroupCell *tmp = m_tree;
+    while (tmp != NULL && tmp->m_currentPoint.y + tmp->GetMaxDrop() < point.y)
+      tmp = dynamic_cast<GroupCell*>(tmp->m_next);
+    if (tmp != NULL && tmp->m_currentPoint.y - tmp->GetMaxCenter() <= point.y)
+      tip = tmp->GetTimingText();
+  }
+
+  if (tip != m_timingToolTip) {
+    m_timingToolTip = tip;
+    if (tip.Length())
+      SetToolTip(tip);
+    else
+      SetToolTip((wxToolTip *)NULL);
+  }
+}
+
 /***
  * Select the rectangle surrounded by down and up. Called from OnMouseMotion.
  *
@@ -1908,6 +2251,9 @@ void MathCtrl::OnTimer(wxTimerEvent& event) {
         m_timer.Start(50, true);
       }
       break;
+    case OUTPUT_TIMER_ID:
+      FlushOutput();
+      break;
     case ANIMATION_TIMER_ID:
       {
         if (m_selectionStart != NULL && m_selectionStart == m_selectionEnd &&
@@ -2798,6 +3144,7 @@ wxString ConvertToUnicode(wxString str)
 
 bool MathCtrl::ExportToWXMX(wxString file)
 {
+  PROFILE_SCOPE("ExportToWXMX");
   // delete file if it already exists
   if(wxFileExists(file))
     if(!wxRemoveFile(file))
@@ -3430,6 +3777,9 @@ void MathCtrl::Animate(bool run) {
 }
 
 void MathCtrl::SetWorkingGroup(GroupCell *group) {
+  // pending output goes to the old working group
+  if (group != m_workingGroup)
+    FlushOutput();
   if (m_workingGroup != NULL)
     m_workingGroup->SetWorking(false);
   m_workingGroup = group;
@@ -3696,7 +4046,7 @@ void MathCtrl::Replace(wxString oldString, wxString newString)
     {
       m_saved = false;
       dynamic_cast<GroupCell*>(m_activeCell->GetParent())->ResetInputLabel();
-      RecalculateForce();
+      ScheduleRecalculate(true);
       Refresh();
     }
   }
@@ -3732,7 +4082,7 @@ int MathCtrl::ReplaceAll(wxString oldString, wxString newString)
   if (count > 0)
   {
     m_saved = false;
-    RecalculateForce();
+    ScheduleRecalculate(true);
     Refresh();
   }
 
@@ -3896,6 +4246,7 @@ void MathCtrl::OpenNextOrCreateCell()
 BEGIN_EVENT_TABLE(MathCtrl, wxScrolledCanvas)
   EVT_MENU_RANGE(popid_complete_00, popid_complete_00 + AC_MENU_LENGTH, MathCtrl::OnComplete)
   EVT_SIZE(MathCtrl::OnSize)
+  EVT_IDLE(MathCtrl::OnIdle)
   EVT_PAINT(MathCtrl::OnPaint)
   EVT_LEFT_UP(MathCtrl::OnMouseLeftUp)
   EVT_LEFT_DOWN(MathCtrl::OnMouseLeftDown)
@@ -3907,6 +4258,7 @@ BEGIN_EVENT_TABLE(MathCtrl, wxScrolledCanvas)
   EVT_TIMER(TIMER_ID, MathCtrl::OnTimer)
   EVT_TIMER(CARET_TIMER_ID, MathCtrl::OnTimer)
   EVT_TIMER(ANIMATION_TIMER_ID, MathCtrl::OnTimer)
+  EVT_TIMER(OUTPUT_TIMER_ID, MathCtrl::OnTimer)
   EVT_KEY_DOWN(MathCtrl::OnKeyDown)
   EVT_CHAR(MathCtrl::OnChar)
   EVT_ERASE_BACKGROUND(MathCtrl::OnEraseBackground)
@@ -27,6 +27,8 @@
 #include "MathCell.h"
 #include "EditorCell.h"
 #include "GroupCell.h"
+#include "ElisionCell.h"
+#include "PlainTextCell.h"
 #include "EvaluationQueue.h"
 #include "Autocomplete.h"
 
@@ -67,6 +69,7 @@ enum {
   popid_insert_title,
   popid_insert_section,
   popid_insert_subsection,
+  popid_text_output,
   // popid_complete_00 should be the last id
   popid_complete_00
 };
@@ -88,8 +91,14 @@ public:
   MathCell* CopyTree();
   GroupCell *InsertGroupCells(GroupCell* tree, GroupCell* where = NULL);
   void InsertLine(MathCell *newLine, bool forceNewLine = false);
+  void AppendPlainText(PlainTextCell *cell);
+  void FlushOutput();
+  bool IsTextOutput(GroupCell *group);
+  void SwitchTextOutput();
   void Recalculate(bool force = false);
   void RecalculateForce();
+  void RecalculateVisible();
+  void ScheduleRecalculate(bool force = false);
   void ClearDocument(); // used when opening new file in wxMaxima.cpp
   void ResetInputPrompts();
   bool CanCopy(bool fromActive = false)
@@ -197,7 +206,7 @@ public:
   // methods for zooming the document in and out
   double GetZoomFactor() { return m_zoomFactor; }
   void SetZoomFactor(double newzoom, bool recalc = true) { m_zoomFactor = newzoom;
-    if (recalc) {RecalculateForce(); Refresh();} }
+    if (recalc) {ScheduleRecalculate(true); Refresh();} }
   void CommentSelection();
   void OnMouseWheel(wxMouseEvent &ev);
   bool FindNext(wxString str, bool down, bool ignoreCase);
@@ -221,10 +230,14 @@ protected:
   void OnMouseEnter(wxMouseEvent& event);
   void OnPaint(wxPaintEvent& event);
   void OnSize(wxSizeEvent& event);
+  void OnIdle(wxIdleEvent& event);
+  void RecalculateGroup(CellParser& parser, GroupCell *group, bool force = false);
   void OnMouseRightDown(wxMouseEvent& event);
   void OnMouseLeftUp(wxMouseEvent& event);
   void OnMouseLeftDown(wxMouseEvent& event);
   void OnMouseMotion(wxMouseEvent& event);
+  void UpdateTimingToolTip(wxMouseEvent& event);
+  void ExpandElision(GroupCell *group, ElisionCell *elision);
   void OnDoubleClick(wxMouseEvent& event);
   void OnKeyDown(wxKeyEvent& event);
   void OnChar(wxKeyEvent& event);
@@ -249,6 +262,7 @@ protected:
   GroupCell *m_tree;
   GroupCell *m_last;
   GroupCell *m_workingGroup;
+  wxString m_timingToolTip;
   MathCell *m_selectionStart;
   MathCell *m_selectionEnd;
   int m_clickType;
@@ -258,10 +272,14 @@ protected:
   bool m_switchDisplayCaret;
   bool m_editingEnabled;
   wxTimer m_timer, m_caretTimer, m_animationTimer;
+  wxTimer m_outputTimer;
+  bool m_outputPending; // output was appended but not laid out yet
   bool m_animate;
   wxBitmap *m_memory;
   bool m_saved;
   double m_zoomFactor;
+  bool m_layoutPending; // some groups wait for OnIdle to recalculate them
+  bool m_layoutForce; // the pending groups must be measured again
   AutoComplete m_autocomplete;
   wxArrayString m_completions;
   bool m_autocompleteTemplates;
@@ -23,7 +23,10 @@
 #include <wx/sstream.h>
 #include <wx/regex.h>
 
+#include <vector>
+
 #include "MathParser.h"
+#include "Profiler.h"
 
 #include "FracCell.h"
 #include "ExptCell.h"
@@ -44,14 +47,20 @@
 #include "SubSupCell.h"
 #include "SlideShowCell.h"
 #include "GroupCell.h"
+#include "ElisionCell.h"
+#include "PlainTextCell.h"
+#include "BigNumberCell.h"
 
 #define MAXLENGTH 50000
+#define ELIDE_TERMS 20             // terms shown on each side of an elision
+#define ELIDE_LENGTH (MAXLENGTH/4) // characters of xml shown on each side
 
 MathParser::MathParser(wxString zipfile)
 {
   m_ParserStyle = MC_TYPE_DEFAULT;
   m_FracStyle = FC_NORMAL;
   m_highlight = false;
+  m_elideNumbers = false;
   if (zipfile.Length() > 0) {
     m_fileSystem = new wxFileSystem();
     m_fileSystem->ChangePathTo(wxT("file:") + zipfile + wxT("#zip:/"), true);
@@ -81,6 +90,15 @@ MathCell* MathParser::ParseCellTag(wxXmlNode* node)
   bool hide = (node->GetAttribute(wxT("hide"), wxT("false")) == wxT("true")) ? true : false;
 #else
   bool hide = (node->GetPropVal(wxT("hide"), wxT("false")) == wxT("true")) ? true : false;
+#endif
+  // read evaluation timing
+  long evaluationTime = -1, displayTime = 0;
+#if wxCHECK_VERSION(2,9,0)
+  node->GetAttribute(wxT("evaltime"), wxT("-1")).ToLong(&evaluationTime);
+  node->GetAttribute(wxT("displaytime"), wxT("0")).ToLong(&displayTime);
+#else
+  node->GetPropVal(wxT("evaltime"), wxT("-1")).ToLong(&evaluationTime);
+  node->GetPropVal(wxT("displaytime"), wxT("0")).ToLong(&displayTime);
 #endif
   // read (group)cell type
 #if wxCHECK_VERSION(2,9,0)
@@ -169,6 +187,8 @@ MathCell* MathParser::ParseCellTag(wxXmlNode* node)
 
   group->SetParent(group, false);
   group->Hide(hide);
+  group->SetEvaluationTime(evaluationTime);
+  group->AddDisplayTime(displayTime);
   return group;
 }
 
@@ -395,14 +415,14 @@ MathCell* MathParser::ParseText(wxXmlNode* node, int style)
     wxString str1(str.wc_str(wxConvUTF8), *wxConvCurrent);
     str = str1;
 #endif
+    if (style == TS_NUMBER && str.Length() > BIGNUM_MIN && str.IsAscii())
+    {
+      delete cell;
+      return ParseBigNumber(str);
+    }
 #if wxUSE_UNICODE
     str.Replace(wxT("-"), wxT("\x2212")); // unicode minus sign
 #endif
-    if (style == TS_NUMBER)
-    {
-      if (str.Length() > 100) // This could be made configurable.
-        str = str.Left(30) + wxString::Format(wxT("[%d digits]"), str.Length() - 60) + str.Right(30);
-    }
     cell->SetType(m_ParserStyle);
     cell->SetStyle(style);
     cell->SetHighlight(m_highlight);
@@ -411,6 +431,37 @@ MathCell* MathParser::ParseText(wxXmlNode* node, int style)
   return cell;
 }
 
+/***
+ * Numbers with many digits go to a BigNumberCell. Very long ones show
+ * only their first and last digits, unless long expressions are shown.
+ */
+MathCell* MathParser::ParseBigNumber(const wxString& str)
+{
+  size_t shown = str.Length();
+  if (m_elideNumbers && str.Length() > BIGNUM_ELIDE)
+    shown = BIGNUM_SHOWN;
+
+  MathCell *cell = new BigNumberCell(str.Left(shown));
+  cell->SetType(m_ParserStyle);
+  cell->SetStyle(TS_NUMBER);
+  cell->SetHighlight(m_highlight);
+  if (shown == str.Length())
+    return cell;
+
+  wxString hidden = str.Mid(shown, str.Length() - 2 * shown);
+  ElisionCell *elision = new ElisionCell(wxT("<n>") + hidden + wxT("</n>"), hidden.Length(), true);
+  elision->SetType(m_ParserStyle);
+  cell->AppendCell(elision);
+
+  MathCell *tail = new BigNumberCell(str.Right(shown));
+  tail->SetType(m_ParserStyle);
+  tail->SetStyle(TS_NUMBER);
+  tail->SetHighlight(m_highlight);
+  cell->AppendCell(tail);
+
+  return cell;
+}
+
 MathCell* MathParser::ParseCharCode(wxXmlNode* node, int style)
 {
   TextCell* cell = new TextCell;
@@ -615,6 +666,13 @@ MathCell* MathParser::ParseTableTag(wxXmlNode* node)
     matrix->RowNames(true);
 #endif
 
+  // large matrices keep the xml of their entries and parse them later
+  int entries = 0;
+  for (wxXmlNode* rows = node->GetChildren(); rows; rows = rows->GetNext())
+    for (wxXmlNode* cells = rows->GetChildren(); cells; cells = cells->GetNext())
+      entries++;
+  bool virtualMatrix = entries >= MATR_VIRTUAL_MIN;
+
   wxXmlNode* rows = node->GetChildren();
   while (rows)
   {
@@ -623,8 +681,18 @@ MathCell* MathParser::ParseTableTag(wxXmlNode* node)
     while (cells)
     {
       matrix->NewColumn();
-      matrix->AddNewCell(ParseTag(cells, false));
-      cells = cells->GetNext();
+      if (virtualMatrix)
+      {
+        wxXmlNode* next = cells->GetNext();
+        rows->RemoveChild(cells);
+        matrix->AddNewNode(cells, m_ParserStyle, m_highlight);
+        cells = next;
+      }
+      else
+      {
+        matrix->AddNewCell(ParseTag(cells, false));
+        cells = cells->GetNext();
+      }
     }
     rows = rows->GetNext();
   }
@@ -982,12 +1050,47 @@ MathCell* MathParser::ParseTag(wxXmlNode* node, bool all)
   return cell;
 }
 
+/***
+ * The length of the xml s without the digits of its numbers, which are
+ * laid out without being measured.
+ */
+static size_t NumberlessLength(const wxString& s)
+{
+  size_t length = s.Length(), pos = 0;
+  while ((pos = s.find(wxT("<n>"), pos)) != wxString::npos)
+  {
+    size_t end = s.find(wxT("</n>"), pos);
+    if (end == wxString::npos)
+      break;
+    length -= end - pos - 3;
+    pos = end;
+  }
+  return length;
+}
+
+/***
+ * The same for the decoded nodes of the compact encoding.
+ */
+static size_t NumberlessLength(wxXmlNode* node)
+{
+  size_t length = 0;
+  for (; node != NULL; node = node->GetNext())
+  {
+    if (node->GetType() != wxXML_ELEMENT_NODE)
+      length += node->GetContent().Length();
+    else if (node->GetName() != wxT("n"))
+      length += 2 * node->GetName().Length() + 5 + NumberlessLength(node->GetChildren());
+  }
+  return length;
+}
+
 /***
  * Parse the string s, which is (correct) xml fragment.
  * Put the result in line.
  */
 MathCell* MathParser::ParseLine(wxString s, int style)
 {
+  PROFILE_SCOPE("ParseLine");
   m_ParserStyle = style;
   m_FracStyle = FC_NORMAL;
   m_highlight = false;
@@ -1005,29 +1108,761 @@ MathCell* MathParser::ParseLine(wxString s, int style)
   graph.Replace(&s, wxT("?"));
 #endif
 
-  if (s.Length() < MAXLENGTH || showLong)
+  m_elideNumbers = !showLong;
+
+  if (s.Length() < MAXLENGTH || showLong || NumberlessLength(s) < MAXLENGTH)
+    cell = ParseXml(s, style);
+  else if ((cell = ParseElided(s, style)) == NULL)
   {
+    cell = new TextCell(_(" << Expression too long to display! >>"));
+    cell->ForceBreakLine(true);
+  }
+  m_elideNumbers = false;
+  return cell;
+}
 
-    wxXmlDocument xml;
+/***
+ * Parse the xml fragment s, without any checks of its length.
+ */
+MathCell* MathParser::ParseXml(const wxString& s, int style)
+{
+  m_ParserStyle = style;
+  m_FracStyle = FC_NORMAL;
+  m_highlight = false;
+  MathCell* cell = NULL;
+
+  wxXmlDocument xml;
 
 #if wxUSE_UNICODE
-    wxStringInputStream xmlStream(s);
+  wxStringInputStream xmlStream(s);
 #else
-    wxString su(s.wc_str(*wxConvCurrent), wxConvUTF8);
-    wxStringInputStream xmlStream(su);
+  wxString su(s.wc_str(*wxConvCurrent), wxConvUTF8);
+  wxStringInputStream xmlStream(su);
 #endif
 
-    xml.Load(xmlStream);
+  xml.Load(xmlStream);
+
+  wxXmlNode *doc = xml.GetRoot();
 
-    wxXmlNode *doc = xml.GetRoot();
+  if (doc != NULL)
+    cell = ParseTag(doc->GetChildren());
+
+  return cell;
+}
 
-    if (doc != NULL)
-      cell = ParseTag(doc->GetChildren());
+/***
+ * Parse one node, which was kept from an earlier parse.
+ */
+MathCell* MathParser::ParseNode(wxXmlNode* node, int style, bool highlight)
+{
+  m_ParserStyle = style;
+  m_FracStyle = FC_NORMAL;
+  m_highlight = highlight;
+
+  return ParseTag(node, false);
+}
+
+/***
+ * Append the text of node and its siblings to text. Return false if they
+ * hold anything which is not shown as plain text in 2D either.
+ */
+static bool PlainText(wxXmlNode* node, wxString& text)
+{
+  while (node != NULL)
+  {
+    if (node->GetType() == wxXML_ELEMENT_NODE)
+    {
+      wxString tagName(node->GetName());
+
+      if (tagName == wxT("mspace"))
+        text += wxT(" ");
+      else if (tagName == wxT("v") || tagName == wxT("t") || tagName == wxT("n") ||
+               tagName == wxT("h") || tagName == wxT("s") || tagName == wxT("st") ||
+               tagName == wxT("fnm") || tagName == wxT("hl"))
+      {
+        if (!PlainText(node->GetChildren(), text))
+          return false;
+      }
+      else if (tagName == wxT("lbl"))
+      {
+        if (!PlainText(node->GetChildren(), text))
+          return false;
+        text += wxT(" ");
+      }
+      else
+        return false;
+    }
+    else
+      text += node->GetContent();
+    node = node->GetNext();
+  }
+  return true;
+}
+
+/***
+ * Parse the output lines in the xml s into one PlainTextCell, which
+ * keeps the xml of each line. Return NULL if a line needs 2D layout.
+ */
+MathCell* MathParser::ParsePlainText(const wxString& s, int style)
+{
+  PROFILE_SCOPE("ParsePlainText");
+  wxXmlDocument xml;
+
+#if wxUSE_UNICODE
+  wxStringInputStream xmlStream(s);
+#else
+  wxString su(s.wc_str(*wxConvCurrent), wxConvUTF8);
+  wxStringInputStream xmlStream(su);
+#endif
+
+  xml.Load(xmlStream);
+
+  wxXmlNode *doc = xml.GetRoot();
+  if (doc == NULL || doc->GetChildren() == NULL)
+    return NULL;
+
+  PlainTextCell *cell = new PlainTextCell;
+  cell->SetType(style);
+
+  size_t pos = 0;
+  for (wxXmlNode *node = doc->GetChildren(); node != NULL; node = node->GetNext())
+  {
+    wxString text;
+    size_t start = s.find(wxT("<mth>"), pos), end = wxString::npos;
+    if (start != wxString::npos)
+      end = s.find(wxT("</mth>"), start);
+
+    if (node->GetType() != wxXML_ELEMENT_NODE || node->GetName() != wxT("mth") ||
+        end == wxString::npos || !PlainText(node->GetChildren(), text))
+    {
+      delete cell;
+      return NULL;
+    }
+
+    text.Replace(wxT("\n"), wxT(" "));
+    cell->AppendLine(text, s.SubString(start + 5, end - 1));
+    pos = end + 6;
+  }
+
+  return cell;
+}
+
+/***
+ * Split the xml s into its top level elements and text.
+ */
+static bool SplitTopLevel(const wxString& s, wxArrayString& parts)
+{
+  int depth = 0;
+  size_t start = 0, i = 0, length = s.Length();
+
+  while (i < length)
+  {
+    if (s[i] == wxT('<'))
+    {
+      size_t close = s.find(wxT('>'), i);
+      if (close == wxString::npos)
+        return false;
+      if (s[i + 1] == wxT('/'))
+        depth--;
+      else if (s[close - 1] != wxT('/'))
+        depth++;
+      if (depth < 0)
+        return false;
+      i = close + 1;
+    }
+    else
+    {
+      i = s.find(wxT('<'), i);
+      if (i == wxString::npos)
+        i = length;
+    }
+
+    if (depth == 0)
+    {
+      parts.Add(s.Mid(start, i - start));
+      start = i;
+    }
+  }
+
+  return depth == 0;
+}
+
+/***
+ * The kinds of top level parts ParseElided looks at. The separators are
+ * ordered by how loosely they bind, so the loosest one found is the top
+ * level operator.
+ */
+enum ElisionPartKind
+{
+  PART_OTHER,
+  PART_LABEL,
+  PART_OPEN,
+  PART_CLOSE,
+  PART_PRODUCT,
+  PART_SUM,
+  PART_COMMA
+};
+
+/***
+ * The kind of a part with element name and text content.
+ */
+static ElisionPartKind PartKind(const wxString& name, const wxString& content)
+{
+  if (name == wxT("lbl"))
+    return PART_LABEL;
+  if (name == wxT("v") && (content == wxT("+") || content == wxT("-")))
+    return PART_SUM;
+  if ((name == wxT("h") || name == wxT("t")) && content == wxT("*"))
+    return PART_PRODUCT;
+  if (name != wxT("t"))
+    return PART_OTHER;
+  if (content == wxT(","))
+    return PART_COMMA;
+  if (content == wxT("[") || content == wxT("{"))
+    return PART_OPEN;
+  if (content == wxT("]") || content == wxT("}"))
+    return PART_CLOSE;
+  return PART_OTHER;
+}
+
+/***
+ * The kind of a top level part of the xml, like <v>+</v>.
+ */
+static ElisionPartKind PartKind(const wxString& part)
+{
+  if (!part.StartsWith(wxT("<")))
+    return PART_OTHER;
+  int close = part.Find(wxT('>'));
+  if (close == wxNOT_FOUND)
+    return PART_OTHER;
+  wxString name = part.SubString(1, close - 1);
+  if (name.StartsWith(wxT("lbl")))
+    return PART_LABEL;
+  wxString end = wxT("</") + name + wxT(">");
+  if (!part.EndsWith(end) || part.Length() < close + 1 + end.Length())
+    return PART_OTHER;
+  wxString content = part.Mid(close + 1, part.Length() - close - 1 - end.Length());
+  if (content.Find(wxT('<')) != wxNOT_FOUND)
+    return PART_OTHER;
+  return PartKind(name, content);
+}
+
+/***
+ * Find the parts which separate the terms of the top level operator. Only
+ * the loosest binding separator outside of brackets counts, so the factors
+ * of a term in a sum or the sums inside a list element are not split, and
+ * a minus sign without a term before it is a prefix. If the whole
+ * expression is one list or set its elements are the terms.
+ */
+static void TopLevelSeparators(const std::vector<ElisionPartKind>& kinds,
+                               std::vector<size_t>& separators)
+{
+  std::vector<int> depths(kinds.size());
+  int depth = 0;
+  size_t firstPart = 0, firstClosed = kinds.size();
+  for (size_t i = 0; i < kinds.size(); i++)
+  {
+    if (kinds[i] == PART_CLOSE)
+      depth--;
+    depths[i] = depth;
+    if (kinds[i] == PART_OPEN)
+      depth++;
+    if (kinds[i] == PART_LABEL && i == firstPart)
+      firstPart++;
+    else if (depth == 0 && firstClosed == kinds.size())
+      firstClosed = i;
   }
+
+  // the elements of a single list are at depth 1
+  int top = 0;
+  if (firstPart < kinds.size() && kinds[firstPart] == PART_OPEN &&
+      firstClosed == kinds.size() - 1)
+    top = 1;
+
+  ElisionPartKind loosest = PART_OTHER;
+  std::vector<bool> candidate(kinds.size(), false);
+  for (size_t i = 0; i < kinds.size(); i++)
+  {
+    if (kinds[i] < PART_PRODUCT || depths[i] != top)
+      continue;
+    // a separator without a term before it is a prefix
+    if (i == 0 || kinds[i - 1] == PART_LABEL || kinds[i - 1] == PART_OPEN ||
+        kinds[i - 1] >= PART_PRODUCT)
+      continue;
+    candidate[i] = true;
+    if (kinds[i] > loosest)
+      loosest = kinds[i];
+  }
+
+  for (size_t i = 0; i < kinds.size(); i++)
+    if (candidate[i] && kinds[i] == loosest)
+      separators.push_back(i);
+}
+
+/***
+ * Choose the terms to hide, given the lengths of the top level parts and
+ * the indices of the parts which separate terms. The head ends before
+ * separator first, the tail starts at separator last, or is empty if last
+ * is the number of separators. Returns false if there are no separators
+ * or the first term is already too long.
+ */
+static bool ChooseElision(const std::vector<size_t>& lengths,
+                          const std::vector<size_t>& separators,
+                          size_t& first, size_t& last)
+{
+  if (separators.empty())
+    return false;
+
+  first = 0;
+  last = separators.size();
+  size_t headLength = 0, tailLength = 0;
+  for (size_t i = 0, part = 0; i < separators.size() && i < ELIDE_TERMS; i++)
+  {
+    for (; part < separators[i]; part++)
+      headLength += lengths[part];
+    if (headLength > ELIDE_LENGTH)
+      break;
+    first = i + 1;
+  }
+  if (first == 0)
+    return false;
+  first--;
+
+  for (size_t i = separators.size(), part = lengths.size();
+       i > first + 1 && separators.size() - i < ELIDE_TERMS; i--)
+  {
+    for (; part > separators[i - 1]; part--)
+      tailLength += lengths[part - 1];
+    if (tailLength > ELIDE_LENGTH)
+      break;
+    last = i - 1;
+  }
+
+  return true;
+}
+
+/***
+ * Parse a result which is too long to display by showing only the first
+ * and last ELIDE_TERMS terms of its top level sum, product or list. The
+ * terms in between go into an ElisionCell. Returns NULL if s can not be
+ * shortened this way.
+ */
+MathCell* MathParser::ParseElided(const wxString& s, int style)
+{
+  int start = s.Find(wxT("<mth>"));
+  int end = s.Find(wxT("</mth>"));
+  if (start == wxNOT_FOUND || end == wxNOT_FOUND || end < start)
+    return NULL;
+
+  wxArrayString parts;
+  if (!SplitTopLevel(s.SubString(start + 5, end - 1), parts))
+    return NULL;
+
+  // the terms are separated by these
+  std::vector<ElisionPartKind> kinds;
+  for (size_t i = 0; i < parts.GetCount(); i++)
+    kinds.push_back(PartKind(parts[i]));
+  std::vector<size_t> separators;
+  TopLevelSeparators(kinds, separators);
+
+  std::vector<size_t> lengths;
+  for (size_t i = 0; i < parts.GetCount(); i++)
+    lengths.push_back(parts[i].Length());
+
+  size_t first, last;
+  if (!ChooseElision(lengths, separators, first, last))
+    return NULL;
+
+  wxString head, hidden, tail;
+  size_t hiddenEnd = last < separators.size() ? separators[last] : parts.GetCount();
+  for (size_t i = 0; i < separators[first]; i++)
+    head += parts[i];
+  for (size_t i = separators[first]; i < hiddenEnd; i++)
+    hidden += parts[i];
+  for (size_t i = hiddenEnd; i < parts.GetCount(); i++)
+    tail += parts[i];
+
+  MathCell *cell = ParseXml(wxT("<span><mth>") + head + wxT("</mth></span>"), style);
+  if (cell == NULL)
+    return NULL;
+
+  ElisionCell *elision = new ElisionCell(hidden, last - first);
+  elision->SetType(style);
+  cell->AppendCell(elision);
+
+  if (tail.Length())
+    cell->AppendCell(ParseXml(wxT("<span>") + tail + wxT("</span>"), style));
+
+  return cell;
+}
+
+/***
+ * The same as PartKind for a decoded node.
+ */
+static ElisionPartKind PartKind(wxXmlNode* node)
+{
+  if (node->GetType() != wxXML_ELEMENT_NODE)
+    return PART_OTHER;
+  if (node->GetName() == wxT("lbl"))
+    return PART_LABEL;
+
+  wxXmlNode *text = node->GetChildren();
+  if (text == NULL || text->GetType() != wxXML_TEXT_NODE || text->GetNext() != NULL)
+    return PART_OTHER;
+  return PartKind(node->GetName(), text->GetContent());
+}
+
+/***
+ * Escape text for xml.
+ */
+static wxString EscapeXml(wxString text)
+{
+  text.Replace(wxT("&"), wxT("&amp;"));
+  text.Replace(wxT("<"), wxT("&lt;"));
+  text.Replace(wxT(">"), wxT("&gt;"));
+  text.Replace(wxT("\""), wxT("&quot;"));
+  return text;
+}
+
+/***
+ * Append the xml of the decoded node and its children to xml.
+ */
+static void AppendXml(wxXmlNode* node, wxString& xml)
+{
+  if (node->GetType() != wxXML_ELEMENT_NODE)
+  {
+    xml += EscapeXml(node->GetContent());
+    return;
+  }
+
+  xml += wxT("<") + node->GetName();
+#if wxCHECK_VERSION(2,9,0)
+  for (wxXmlAttribute *attr = node->GetAttributes(); attr != NULL; attr = attr->GetNext())
+#else
+  for (wxXmlProperty *attr = node->GetProperties(); attr != NULL; attr = attr->GetNext())
+#endif
+    xml += wxT(" ") + attr->GetName() + wxT("=\"") + EscapeXml(attr->GetValue()) + wxT("\"");
+  xml += wxT(">");
+
+  for (wxXmlNode *child = node->GetChildren(); child != NULL; child = child->GetNext())
+    AppendXml(child, xml);
+
+  xml += wxT("</") + node->GetName() + wxT(">");
+}
+
+/***
+ * The length of the xml of the decoded node, without escapes and
+ * attributes.
+ */
+static size_t XmlLength(wxXmlNode* node)
+{
+  if (node->GetType() != wxXML_ELEMENT_NODE)
+    return node->GetContent().Length();
+
+  size_t length = 2 * node->GetName().Length() + 5;
+  for (wxXmlNode *child = node->GetChildren(); child != NULL; child = child->GetNext())
+    length += XmlLength(child);
+  return length;
+}
+
+/***
+ * The same as ParseElided for the decoded nodes of the compact encoding.
+ * node is the <mth> element. The head is parsed from node with the parts
+ * after it cut off, and the hidden terms are kept as xml.
+ */
+MathCell* MathParser::ParseElided(wxXmlNode* node, int style)
+{
+  if (node == NULL || node->GetType() != wxXML_ELEMENT_NODE ||
+      node->GetName() != wxT("mth") || node->GetNext() != NULL)
+    return NULL;
+
+  std::vector<wxXmlNode*> parts;
+  for (wxXmlNode *part = node->GetChildren(); part != NULL; part = part->GetNext())
+    parts.push_back(part);
+
+  std::vector<size_t> lengths, separators;
+  std::vector<ElisionPartKind> kinds;
+  for (size_t i = 0; i < parts.size(); i++)
+  {
+    lengths.push_back(XmlLength(parts[i]));
+    kinds.push_back(PartKind(parts[i]));
+  }
+  TopLevelSeparators(kinds, separators);
+
+  size_t first, last;
+  if (!ChooseElision(lengths, separators, first, last))
+    return NULL;
+
+  wxString hidden;
+  size_t hiddenEnd = last < separators.size() ? separators[last] : parts.size();
+  for (size_t i = separators[first]; i < hiddenEnd; i++)
+    AppendXml(parts[i], hidden);
+
+  wxXmlNode *rest = parts[separators[first]];
+  if (separators[first] > 0)
+    parts[separators[first] - 1]->SetNext(NULL);
+  else
+    node->SetChildren(NULL);
+
+  MathCell *cell = ParseTag(node, false);
+
+  if (separators[first] > 0)
+    parts[separators[first] - 1]->SetNext(rest);
   else
+    node->SetChildren(rest);
+
+  if (cell == NULL)
+    return NULL;
+
+  ElisionCell *elision = new ElisionCell(hidden, last - first);
+  elision->SetType(style);
+  cell->AppendCell(elision);
+
+  if (hiddenEnd < parts.size())
+    cell->AppendCell(ParseTag(parts[hiddenEnd]));
+
+  return cell;
+}
+
+/***
+ * The same as ParsePlainText for the decoded nodes of the compact
+ * encoding. The xml kept for each line is written from the nodes.
+ */
+MathCell* MathParser::ParsePlainText(wxXmlNode* root, int style)
+{
+  PROFILE_SCOPE("ParsePlainText");
+  if (root->GetChildren() == NULL)
+    return NULL;
+
+  PlainTextCell *cell = new PlainTextCell;
+  cell->SetType(style);
+
+  for (wxXmlNode *node = root->GetChildren(); node != NULL; node = node->GetNext())
   {
-    cell = new TextCell(_(" << Expression too long to display! >>"));
-    cell->ForceBreakLine(true);
+    wxString text, xml;
+    if (node->GetType() != wxXML_ELEMENT_NODE || node->GetName() != wxT("mth") ||
+        !PlainText(node->GetChildren(), text))
+    {
+      delete cell;
+      return NULL;
+    }
+
+    for (wxXmlNode *child = node->GetChildren(); child != NULL; child = child->GetNext())
+      AppendXml(child, xml);
+
+    text.Replace(wxT("\n"), wxT(" "));
+    cell->AppendLine(text, xml);
+  }
+
+  return cell;
+}
+
+/***
+ * Parse a result in the compact display encoding of wxmathml.
+ *
+ * The encoding is the xml tree written in prefix form with length
+ * prefixed text:
+ *   element    (name @attribute=LENGTH:value ... children)
+ *   text       LENGTH:characters
+ * Text keeps the xml escapes &amp; &lt; &gt;, so it never contains '<'
+ * and can not be confused with the prompt markers.
+ *
+ * The nodes are built directly, without the xml parser, and go to the
+ * same tag parsers as ParseLine, so both encodings give the same cells.
+ * With plainText set a result of only text becomes a PlainTextCell, like
+ * with ParsePlainText.
+ */
+MathCell* MathParser::ParseCompact(const wxString& s, int style, bool plainText)
+{
+  PROFILE_SCOPE("ParseCompact");
+  m_ParserStyle = style;
+  m_FracStyle = FC_NORMAL;
+  m_highlight = false;
+  MathCell* cell = NULL;
+
+  wxConfigBase* config = wxConfig::Get();
+  bool showLong = false;
+  config->Read(wxT("showLong"), &showLong);
+
+  wxXmlNode *root = new wxXmlNode(wxXML_ELEMENT_NODE, wxT("span"));
+  size_t pos = 0;
+  bool decoded = DecodeCompact(s, pos, root) && pos == s.Length();
+
+  if (decoded && plainText)
+    cell = ParsePlainText(root, style);
+
+  if (decoded && cell == NULL)
+  {
+    m_elideNumbers = !showLong;
+    if (s.Length() < MAXLENGTH || showLong || NumberlessLength(root) < MAXLENGTH)
+      cell = ParseTag(root->GetChildren());
+    else if ((cell = ParseElided(root->GetChildren(), style)) == NULL)
+    {
+      cell = new TextCell(_(" << Expression too long to display! >>"));
+      cell->ForceBreakLine(true);
+    }
+    m_elideNumbers = false;
   }
+  delete root;
+
   return cell;
 }
+
+/***
+ * Read the children of parent, up to its closing ')' or the end of s.
+ */
+bool MathParser::DecodeCompact(const wxString& s, size_t& pos, wxXmlNode* parent)
+{
+  wxXmlNode *last = NULL;
+
+  while (pos < s.Length() && s[pos] != wxT(')'))
+  {
+    wxXmlNode *node;
+
+    if (s[pos] == wxT('('))
+    {
+      size_t name = s.find(wxT(' '), pos);
+      if (name == wxString::npos)
+        return false;
+      node = new wxXmlNode(wxXML_ELEMENT_NODE, s.Mid(pos + 1, name - pos - 1));
+      pos = name + 1;
+
+      while (pos < s.Length() && s[pos] == wxT('@'))
+      {
+        size_t eq = s.find(wxT('='), pos);
+        wxString value;
+        if (eq == wxString::npos)
+        {
+          delete node;
+          return false;
+        }
+        wxString attribute = s.Mid(pos + 1, eq - pos - 1);
+        pos = eq + 1;
+        if (!DecodeCompactText(s, pos, value))
+        {
+          delete node;
+          return false;
+        }
+#if wxCHECK_VERSION(2,9,0)
+        node->AddAttribute(attribute, value);
+#else
+        node->AddProperty(attribute, value);
+#endif
+      }
+
+      if (!DecodeCompact(s, pos, node) || pos >= s.Length())
+      {
+        delete node;
+        return false;
+      }
+      pos++; // the closing ')'
+    }
+
+    else
+    {
+      wxString text;
+      if (!DecodeCompactText(s, pos, text))
+        return false;
+
+      // like ParseLine: no newlines, control characters replaced and no
+      // whitespace only text nodes
+      bool white = true;
+      wxString content;
+      content.Alloc(text.Length());
+      for (size_t i = 0; i < text.Length(); i++)
+      {
+        wxChar c = text[i];
+        if (c == wxT('\n'))
+          continue;
+        if (c < 32 || c == 127)
+#if wxUSE_UNICODE
+          c = wxT('\xFFFD');
+#else
+          c = wxT('?');
+#endif
+        if (c != wxT(' '))
+          white = false;
+        content += c;
+      }
+      if (white)
+        continue;
+
+#if !wxUSE_UNICODE
+      wxString su(content.wc_str(*wxConvCurrent), wxConvUTF8);
+      content = su;
+#endif
+      node = new wxXmlNode(wxXML_TEXT_NODE, wxEmptyString, content);
+    }
+
+    node->SetParent(parent);
+    if (last == NULL)
+      parent->SetChildren(node);
+    else
+      last->SetNext(node);
+    last = node;
+  }
+
+  return true;
+}
+
+/***
+ * The position in s after count characters from pos, or wxString::npos if
+ * s ends before. The lengths in the compact encoding count the characters
+ * of the lisp, which are code points, while a wxString of UTF-16 units
+ * (MSW) holds a code point outside the BMP as a surrogate pair.
+ */
+size_t MathParser::SkipCompactChars(const wxString& s, size_t pos, size_t count)
+{
+#if wxUSE_UNICODE
+  if (sizeof(wxChar) == 2)
+  {
+    size_t length = s.Length();
+    for (; count > 0; count--)
+    {
+      if (pos >= length)
+        return wxString::npos;
+      wxChar c = s[pos++];
+      if (c >= 0xD800 && c < 0xDC00)
+      {
+        if (pos >= length)
+          return wxString::npos;
+        pos++;
+      }
+    }
+    return pos;
+  }
+#endif
+  if (pos + count > s.Length())
+    return wxString::npos;
+  return pos + count;
+}
+
+/***
+ * Read LENGTH:characters at pos and undo the xml escapes.
+ */
+bool MathParser::DecodeCompactText(const wxString& s, size_t& pos, wxString& text)
+{
+  size_t colon = s.find(wxT(':'), pos);
+  unsigned long length;
+  if (colon == wxString::npos ||
+      !s.Mid(pos, colon - pos).ToULong(&length))
+    return false;
+
+  size_t end = SkipCompactChars(s, colon + 1, length);
+  if (end == wxString::npos)
+    return false;
+
+  text = s.Mid(colon + 1, end - colon - 1);
+  pos = end;
+
+  if (text.Find(wxT('&')) != wxNOT_FOUND)
+  {
+    text.Replace(wxT("&lt;"), wxT("<"));
+    text.Replace(wxT("&gt;"), wxT(">"));
+    text.Replace(wxT("&quot;"), wxT("\""));
+    text.Replace(wxT("&apos;"), wxT("'"));
+    text.Replace(wxT("&amp;"), wxT("&"));
+  }
+
+  return true;
+}
@@ -34,7 +34,13 @@ public:
   MathParser(wxString zipfile = wxEmptyString);
   ~MathParser();
   MathCell* ParseLine(wxString s, int style = MC_TYPE_DEFAULT);
+  MathCell* ParseCompact(const wxString& s, int style = MC_TYPE_DEFAULT,
+                         bool plainText = false);
+  MathCell* ParseXml(const wxString& s, int style = MC_TYPE_DEFAULT);
+  MathCell* ParsePlainText(const wxString& s, int style = MC_TYPE_DEFAULT);
+  MathCell* ParseNode(wxXmlNode* node, int style, bool highlight);
   MathCell* ParseTag(wxXmlNode* node, bool all = true);
+  static size_t SkipCompactChars(const wxString& s, size_t pos, size_t count);
 private:
   MathCell* ParseCellTag(wxXmlNode* node);
   MathCell* ParseEditorTag(wxXmlNode* node);
@@ -55,9 +61,16 @@ private:
   MathCell* ParseLimitTag(wxXmlNode* node);
   MathCell* ParseParenTag(wxXmlNode* node);
   MathCell* ParseSubSupTag(wxXmlNode* node);
+  MathCell* ParseElided(const wxString& s, int style);
+  MathCell* ParseElided(wxXmlNode* node, int style);
+  MathCell* ParsePlainText(wxXmlNode* root, int style);
+  MathCell* ParseBigNumber(const wxString& str);
+  bool DecodeCompact(const wxString& s, size_t& pos, wxXmlNode* parent);
+  bool DecodeCompactText(const wxString& s, size_t& pos, wxString& text);
   int m_ParserStyle;
   int m_FracStyle;
   bool m_highlight;
+  bool m_elideNumbers; // elide the middle of very long numbers
   wxFileSystem *m_fileSystem; // used for loading pictures in <img> and <slide>
 };
 
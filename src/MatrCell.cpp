@@ -18,6 +18,8 @@
 ///
 
 #include "MatrCell.h"
+#include "MathParser.h"
+#include "TextCell.h"
 
 MatrCell::MatrCell() : MathCell()
 {
@@ -26,6 +28,11 @@ MatrCell::MatrCell() : MathCell()
   m_specialMatrix = false;
   m_inferenceMatrix = false;
   m_rowNames = m_colNames = false;
+  m_virtual = false;
+  m_entryStyle = MC_TYPE_DEFAULT;
+  m_entryHighlight = false;
+  m_generation = 0;
+  m_entryFontSize = -1;
 }
 
 MatrCell::~MatrCell()
@@ -35,10 +42,124 @@ MatrCell::~MatrCell()
     if (m_cells[i] != NULL)
       delete m_cells[i];
   }
+  for (unsigned int i = 0; i < m_nodes.size(); i++)
+    delete m_nodes[i];
   if (m_next != NULL)
     delete m_next;
 }
 
+/***
+ * Count the characters of text and the tags in node.
+ */
+static void MeasureNode(wxXmlNode *node, int& text, int& tags)
+{
+  for (; node != NULL; node = node->GetNext())
+  {
+    if (node->GetType() == wxXML_ELEMENT_NODE)
+    {
+      tags++;
+      MeasureNode(node->GetChildren(), text, tags);
+    }
+    else
+      text += node->GetContent().Length();
+  }
+}
+
+/***
+ * Add an entry of a virtual matrix. The matrix owns node.
+ */
+void MatrCell::AddNewNode(wxXmlNode* node, int style, bool highlight)
+{
+  int text = 0, tags = 0;
+  MeasureNode(node->GetChildren(), text, tags);
+
+  m_virtual = true;
+  m_entryStyle = style;
+  m_entryHighlight = highlight;
+  m_nodes.push_back(node);
+  m_cells.push_back(NULL);
+  m_measured.push_back(-1);
+  m_textLength.push_back(text);
+  m_tagCount.push_back(tags);
+}
+
+/***
+ * The cell of entry i, parsed the first time it is needed.
+ */
+MathCell* MatrCell::GetEntry(int i)
+{
+  if (m_cells[i] == NULL)
+  {
+    m_cells[i] = BorrowEntry(i);
+    m_cells[i]->SetParent(m_group, true);
+  }
+  return m_cells[i];
+}
+
+/***
+ * The cell of entry i without keeping it: give it back with ReturnEntry.
+ */
+MathCell* MatrCell::BorrowEntry(int i)
+{
+  if (m_cells[i] != NULL)
+    return m_cells[i];
+
+  MathParser parser;
+  MathCell *cell = parser.ParseNode(m_nodes[i], m_entryStyle, m_entryHighlight);
+  if (cell == NULL)
+    cell = new TextCell(wxEmptyString);
+  return cell;
+}
+
+void MatrCell::ReturnEntry(int i, MathCell *cell)
+{
+  if (cell != m_cells[i])
+    delete cell;
+}
+
+/***
+ * The entries measured for the sizes of a virtual matrix: in each column
+ * the one with the longest text and in each row the one with the most
+ * structure.
+ */
+void MatrCell::ChooseSamples()
+{
+  vector<bool> sample(m_nodes.size(), false);
+
+  // the longest text is usually the widest entry, the most tags the
+  // tallest, which may be wider too
+  for (int i = 0; i < m_matWidth; i++)
+  {
+    int longest = i, tallest = i;
+    for (int j = 1; j < m_matHeight; j++)
+    {
+      if (m_textLength[m_matWidth * j + i] > m_textLength[longest])
+        longest = m_matWidth * j + i;
+      if (m_tagCount[m_matWidth * j + i] > m_tagCount[tallest])
+        tallest = m_matWidth * j + i;
+    }
+    sample[longest] = sample[tallest] = true;
+  }
+
+  for (int j = 0; j < m_matHeight; j++)
+  {
+    int longest = m_matWidth * j, tallest = m_matWidth * j;
+    for (int i = 1; i < m_matWidth; i++)
+    {
+      if (m_textLength[m_matWidth * j + i] > m_textLength[longest])
+        longest = m_matWidth * j + i;
+      if (m_tagCount[m_matWidth * j + i] > m_tagCount[tallest])
+        tallest = m_matWidth * j + i;
+    }
+    sample[longest] = sample[tallest] = true;
+  }
+
+  m_samples.clear();
+  for (unsigned int i = 0; i < sample.size(); i++)
+    if (sample[i])
+      m_samples.push_back(i);
+}
+
 void MatrCell::SetParent(MathCell *parent, bool all)
 {
   for (unsigned int i = 0; i < m_cells.size(); i++)
@@ -60,8 +181,17 @@ MathCell* MatrCell::Copy(bool all)
   tmp->m_colNames = m_colNames;
   tmp->m_matWidth = m_matWidth;
   tmp->m_matHeight = m_matHeight;
-  for (int i = 0; i < m_matWidth*m_matHeight; i++)
-    (tmp->m_cells).push_back(m_cells[i]->Copy(true));
+  if (m_virtual)
+  {
+    for (int i = 0; i < m_matWidth*m_matHeight; i++)
+      tmp->AddNewNode(new wxXmlNode(*m_nodes[i]), m_entryStyle, m_entryHighlight);
+    tmp->m_samples = m_samples;
+  }
+  else
+  {
+    for (int i = 0; i < m_matWidth*m_matHeight; i++)
+      (tmp->m_cells).push_back(m_cells[i]->Copy(true));
+  }
   if (all && m_next != NULL)
     tmp->AppendCell(m_next->Copy(all));
   return tmp;
@@ -75,23 +205,45 @@ void MatrCell::Destroy()
       delete m_cells[i];
     m_cells[i] = NULL;
   }
+  for (unsigned int i = 0; i < m_nodes.size(); i++)
+    delete m_nodes[i];
+  m_nodes.clear();
+  m_virtual = false;
   m_next = NULL;
 }
 
 void MatrCell::RecalculateWidths(CellParser& parser, int fontsize, bool all)
 {
   double scale = parser.GetScale();
-  for (int i = 0; i < m_matWidth*m_matHeight; i++)
+  m_widths.clear();
+  if (m_virtual)
   {
-    m_cells[i]->RecalculateWidths(parser, MAX(MC_MIN_SIZE, fontsize - 2), true);
+    // only the samples now, the other entries when they are drawn
+    m_generation++;
+    m_entryFontSize = MAX(MC_MIN_SIZE, fontsize - 2);
+    for (int i = 0; i < m_matWidth; i++)
+      m_widths.push_back(0);
+    for (unsigned int k = 0; k < m_samples.size(); k++)
+    {
+      int i = m_samples[k];
+      GetEntry(i)->RecalculateWidths(parser, m_entryFontSize, true);
+      m_widths[i % m_matWidth] = MAX(m_widths[i % m_matWidth],
+                                     m_cells[i]->GetFullWidth(scale));
+    }
   }
-  m_widths.clear();
-  for (int i = 0; i < m_matWidth; i++)
+  else
   {
-    m_widths.push_back(0);
-    for (int j = 0; j < m_matHeight; j++)
+    for (int i = 0; i < m_matWidth*m_matHeight; i++)
     {
-      m_widths[i] = MAX(m_widths[i], m_cells[m_matWidth * j + i]->GetFullWidth(scale));
+      m_cells[i]->RecalculateWidths(parser, MAX(MC_MIN_SIZE, fontsize - 2), true);
+    }
+    for (int i = 0; i < m_matWidth; i++)
+    {
+      m_widths.push_back(0);
+      for (int j = 0; j < m_matHeight; j++)
+      {
+        m_widths[i] = MAX(m_widths[i], m_cells[m_matWidth * j + i]->GetFullWidth(scale));
+      }
     }
   }
   m_width = 0;
@@ -108,20 +260,39 @@ void MatrCell::RecalculateSize(CellParser& parser, int fontsize, bool all)
 {
   double scale = parser.GetScale();
 
-  for (int i = 0; i < m_matWidth*m_matHeight; i++)
-  {
-    m_cells[i]->RecalculateSize(parser, MAX(MC_MIN_SIZE, fontsize - 2), true);
-  }
   m_centers.clear();
   m_drops.clear();
-  for (int i = 0; i < m_matHeight; i++)
+  if (m_virtual)
   {
-    m_centers.push_back(0);
-    m_drops.push_back(0);
-    for (int j = 0; j < m_matWidth; j++)
+    for (int i = 0; i < m_matHeight; i++)
     {
-      m_centers[i] = MAX(m_centers[i], m_cells[m_matWidth * i + j]->GetMaxCenter());
-      m_drops[i] = MAX(m_drops[i], m_cells[m_matWidth * i + j]->GetMaxDrop());
+      m_centers.push_back(0);
+      m_drops.push_back(0);
+    }
+    for (unsigned int k = 0; k < m_samples.size(); k++)
+    {
+      int i = m_samples[k];
+      GetEntry(i)->RecalculateSize(parser, m_entryFontSize, true);
+      m_measured[i] = m_generation;
+      m_centers[i / m_matWidth] = MAX(m_centers[i / m_matWidth], m_cells[i]->GetMaxCenter());
+      m_drops[i / m_matWidth] = MAX(m_drops[i / m_matWidth], m_cells[i]->GetMaxDrop());
+    }
+  }
+  else
+  {
+    for (int i = 0; i < m_matWidth*m_matHeight; i++)
+    {
+      m_cells[i]->RecalculateSize(parser, MAX(MC_MIN_SIZE, fontsize - 2), true);
+    }
+    for (int i = 0; i < m_matHeight; i++)
+    {
+      m_centers.push_back(0);
+      m_drops.push_back(0);
+      for (int j = 0; j < m_matWidth; j++)
+      {
+        m_centers[i] = MAX(m_centers[i], m_cells[m_matWidth * i + j]->GetMaxCenter());
+        m_drops[i] = MAX(m_drops[i], m_cells[m_matWidth * i + j]->GetMaxDrop());
+      }
     }
   }
   m_height = 0;
@@ -135,6 +306,70 @@ void MatrCell::RecalculateSize(CellParser& parser, int fontsize, bool all)
   MathCell::RecalculateSize(parser, fontsize, all);
 }
 
+/***
+ * Draw the entries of a virtual matrix which are inside the bounds of
+ * parser, measuring those not measured since the last layout. The sizes
+ * of the rows and columns come from the samples, so each entry is clipped
+ * to its place. Entries which are out of the visible region of parser now
+ * are dropped, so only the visible entries and the samples stay parsed.
+ */
+void MatrCell::DrawEntries(CellParser& parser, wxPoint point)
+{
+  wxDC& dc = parser.GetDC();
+  double scale = parser.GetScale();
+  int top = parser.GetTop(), bottom = parser.GetBottom();
+  int left = parser.GetLeft(), right = parser.GetRight();
+  wxRect visible = parser.GetVisibleRegion();
+
+  vector<bool> keep(m_cells.size(), false);
+  for (unsigned int k = 0; k < m_samples.size(); k++)
+    keep[m_samples[k]] = true;
+
+  wxPoint mp;
+  mp.x = point.x + SCALE_PX(5, scale);
+  for (int i = 0; i < m_matWidth; i++)
+  {
+    mp.y = point.y - m_center + SCALE_PX(5, scale);
+    for (int j = 0; j < m_matHeight; j++)
+    {
+      mp.y += m_centers[j];
+      int k = j * m_matWidth + i;
+      wxRect place(mp.x, mp.y - m_centers[j], m_widths[i], m_centers[j] + m_drops[j]);
+      if (visible.GetWidth() < 0 || visible.Intersects(place))
+        keep[k] = true;
+      if ((left == -1 || place.GetRight() >= left) &&
+          (right == -1 || place.GetLeft() <= right) &&
+          (top == -1 || place.GetBottom() >= top) &&
+          (bottom == -1 || place.GetTop() <= bottom))
+      {
+        MathCell *cell = GetEntry(k);
+        if (m_measured[k] != m_generation)
+        {
+          cell->RecalculateWidths(parser, m_entryFontSize, true);
+          cell->RecalculateSize(parser, m_entryFontSize, true);
+          m_measured[k] = m_generation;
+        }
+        wxPoint mp1(mp);
+        mp1.x = mp.x + (m_widths[i] - cell->GetFullWidth(scale)) / 2;
+        wxDCClipper clipper(dc, place);
+        cell->Draw(parser, mp1, m_entryFontSize, true);
+      }
+      mp.y += (m_drops[j] + SCALE_PX(10, scale));
+    }
+    mp.x += (m_widths[i] + SCALE_PX(10, scale));
+  }
+
+  for (unsigned int k = 0; k < m_cells.size(); k++)
+  {
+    if (!keep[k] && m_cells[k] != NULL)
+    {
+      delete m_cells[k];
+      m_cells[k] = NULL;
+      m_measured[k] = -1;
+    }
+  }
+}
+
 void MatrCell::Draw(CellParser& parser, wxPoint point, int fontsize, bool all)
 {
   if (DrawThisCell(parser, point))
@@ -144,18 +379,23 @@ void MatrCell::Draw(CellParser& parser, wxPoint point, int fontsize, bool all)
     wxPoint mp;
     mp.x = point.x + SCALE_PX(5, scale);
     mp.y = point.y - m_center;
-    for (int i = 0; i < m_matWidth; i++)
+    if (m_virtual)
+      DrawEntries(parser, point);
+    else
     {
-      mp.y = point.y - m_center + SCALE_PX(5, scale);
-      for (int j = 0; j < m_matHeight; j++)
+      for (int i = 0; i < m_matWidth; i++)
       {
-        mp.y += m_centers[j];
-        wxPoint mp1(mp);
-        mp1.x = mp.x + (m_widths[i] - m_cells[j * m_matWidth + i]->GetFullWidth(scale)) / 2;
-        m_cells[j*m_matWidth + i]->Draw(parser, mp1, MAX(MC_MIN_SIZE, fontsize - 2), true);
-        mp.y += (m_drops[j] + SCALE_PX(10, scale));
+        mp.y = point.y - m_center + SCALE_PX(5, scale);
+        for (int j = 0; j < m_matHeight; j++)
+        {
+          mp.y += m_centers[j];
+          wxPoint mp1(mp);
+          mp1.x = mp.x + (m_widths[i] - m_cells[j * m_matWidth + i]->GetFullWidth(scale)) / 2;
+          m_cells[j*m_matWidth + i]->Draw(parser, mp1, MAX(MC_MIN_SIZE, fontsize - 2), true);
+          mp.y += (m_drops[j] + SCALE_PX(10, scale));
+        }
+        mp.x += (m_widths[i] + SCALE_PX(10, scale));
       }
-      mp.x += (m_widths[i] + SCALE_PX(10, scale));
     }
     SetPen(parser);
     if (m_specialMatrix)
@@ -220,7 +460,9 @@ wxString MatrCell::ToString(bool all)
     s += wxT("[");
     for (int j = 0; j < m_matWidth; j++)
     {
-      s += m_cells[i * m_matWidth + j]->ToString(true);
+      MathCell *cell = BorrowEntry(i * m_matWidth + j);
+      s += cell->ToString(true);
+      ReturnEntry(i * m_matWidth + j, cell);
       if (j < m_matWidth - 1)
         s += wxT(",");
     }
@@ -240,7 +482,9 @@ wxString MatrCell::ToTeX(bool all)
   {
     for (int j = 0; j < m_matWidth; j++)
     {
-      s += m_cells[i * m_matWidth + j]->ToTeX(true);
+      MathCell *cell = BorrowEntry(i * m_matWidth + j);
+      s += cell->ToTeX(true);
+      ReturnEntry(i * m_matWidth + j, cell);
       if (j < m_matWidth - 1)
         s += wxT(" & ");
     }
@@ -267,7 +511,11 @@ wxString MatrCell::ToXML(bool all)
 	{
 	  s += wxT("<mtr>");
 		for (int j = 0; j < m_matWidth; j++)
-			s += wxT("<mtd>") + m_cells[i * m_matWidth + j]->ToXML(true) + wxT("</mtd>");
+		{
+			MathCell *cell = BorrowEntry(i * m_matWidth + j);
+			s += wxT("<mtd>") + cell->ToXML(true) + wxT("</mtd>");
+			ReturnEntry(i * m_matWidth + j, cell);
+		}
 		s += wxT("</mtr>");
 	}
 	s += wxT("</tb>");
@@ -279,13 +527,19 @@ void MatrCell::SetDimension()
 {
   if (m_matHeight != 0)
     m_matWidth = m_matWidth / m_matHeight;
+  if (m_virtual)
+  {
+    ChooseSamples();
+  }
 }
 
 void MatrCell::SelectInner(wxRect& rect, MathCell** first, MathCell** last)
 {
   *first = NULL;
   *last = NULL;
-  for (int i = 0; i < m_matHeight; i++)
+  // the entries of a virtual matrix are dropped when they are scrolled
+  // out of view, so only the whole matrix can be selected
+  for (int i = 0; i < m_matHeight && !m_virtual; i++)
   {
     for (int j = 0; j < m_matWidth; j++)
     {
@@ -22,8 +22,15 @@
 
 #include "MathCell.h"
 
+#include <wx/xml/xml.h>
 #include <vector>
 
+// Matrices with at least this many entries are virtual: the entries are
+// kept as xml and parsed when they are drawn. The width of each column
+// and the height of each row are taken from a few sampled entries, which
+// are parsed with the matrix.
+#define MATR_VIRTUAL_MIN 2500
+
 using namespace std;
 
 class MatrCell : public MathCell
@@ -40,6 +47,7 @@ public:
   {
     m_cells.push_back(cell);
   }
+  void AddNewNode(wxXmlNode* node, int style, bool highlight);
   void NewRow()
   {
     m_matHeight++;
@@ -59,6 +67,11 @@ public:
   void RowNames(bool rn) { m_rowNames = rn; }
   void ColNames(bool cn) { m_colNames = cn; }
 protected:
+  MathCell* GetEntry(int i);
+  MathCell* BorrowEntry(int i);
+  void ReturnEntry(int i, MathCell *cell);
+  void ChooseSamples();
+  void DrawEntries(CellParser& parser, wxPoint point);
   int m_matWidth;
   int m_matHeight;
   bool m_specialMatrix, m_inferenceMatrix, m_rowNames, m_colNames;
@@ -66,6 +79,17 @@ protected:
   vector<int> m_widths;
   vector<int> m_drops;
   vector<int> m_centers;
+  // virtual matrices
+  bool m_virtual;
+  int m_entryStyle;
+  bool m_entryHighlight;
+  vector<wxXmlNode*> m_nodes;  // xml of the entries
+  vector<int> m_textLength;    // length of the text of each entry
+  vector<int> m_tagCount;      // number of tags in each entry
+  vector<int> m_samples;       // entries measured for the sizes
+  vector<int> m_measured;      // layout generation each entry was measured in
+  int m_generation;
+  int m_entryFontSize;
 };
 
 #endif //_MATRCELL_H_
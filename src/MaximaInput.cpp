@@ -0,0 +1,256 @@
+///
+///  Copyright (C) 2004-2011 Andrej Vodopivec <andrej.vodopivec@gmail.com>
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///
+///  You should have received a copy of the GNU General Public License
+///  along with this program; if not, write to the Free Software
+///  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+///
+
+
+#include "MaximaInput.h"
+
+/***
+ * What Maxima understands instead of the Unicode character c, NULL if c
+ * is left as it is.
+ */
+static const wxChar *Replacement(wxChar c)
+{
+#if wxUSE_UNICODE
+  switch (c)
+  {
+  case 0x00B2: return wxT("^2");
+  case 0x00B3: return wxT("^3");
+  case 0x00BD: return wxT("(1/2)");
+  case 0x221A: return wxT("sqrt");
+  case 0x03C0: return wxT("%pi");
+  case 0x2148: return wxT("%i");
+  case 0x2147: return wxT("%e");
+  case 0x221E: return wxT("inf");
+  case 0x22C0: return wxT(" and ");
+  case 0x22C1: return wxT(" or ");
+  case 0x22BB: return wxT(" xor ");
+  case 0x22BC: return wxT(" nand ");
+  case 0x22BD: return wxT(" nor ");
+  case 0x21D2: return wxT(" implies ");
+  case 0x21D4: return wxT(" equiv ");
+  case 0x00AC: return wxT(" not ");
+  case 0x2212: return wxT("-");
+  }
+#endif
+  return NULL;
+}
+
+static bool IsSymbolChar(wxChar c)
+{
+  return wxIsalnum(c) || c == wxT('%') || c == wxT('_');
+}
+
+MaximaInput::MaximaInput(const wxString& input, bool lisp)
+{
+  m_lisp = lisp;
+  m_blank = true;
+
+  size_t length = input.Length();
+  size_t i = 0;
+  while (i < length)
+  {
+    wxChar c = input[i];
+
+    // strings are kept as they are
+    if (c == wxT('"'))
+    {
+      size_t end = i + 1;
+      while (end < length && input[end] != wxT('"'))
+      {
+        if (input[end] == wxT('\\'))
+          end++;
+        end++;
+      }
+      end = wxMin(end + 1, length);
+      wxString string = input.Mid(i, end - i);
+      m_text << string;
+      m_code << string;
+      m_blank = false;
+      i = end;
+    }
+
+    // comments, which can be nested
+    else if (!m_lisp && c == wxT('/') && i + 1 < length && input[i + 1] == wxT('*'))
+    {
+      size_t end = i + 2;
+      int depth = 1;
+      while (end < length && depth > 0)
+      {
+        if (input[end] == wxT('/') && end + 1 < length && input[end + 1] == wxT('*'))
+        {
+          depth++;
+          end += 2;
+        }
+        else if (input[end] == wxT('*') && end + 1 < length && input[end + 1] == wxT('/'))
+        {
+          depth--;
+          end += 2;
+        }
+        else
+          end++;
+      }
+      m_text << input.Mid(i, end - i);
+      m_code << wxT(' ');
+      i = end;
+    }
+
+    // an escaped character, \; doesn't end a statement
+    else if (c == wxT('\\') && i + 1 < length)
+    {
+      m_text << c << input[i + 1];
+      m_code << c << input[i + 1];
+      m_blank = false;
+      i += 2;
+    }
+
+    else if (!m_lisp && (c == wxT(';') || c == wxT('$')))
+    {
+      EndStatement(c);
+      i++;
+    }
+
+    else
+    {
+      const wxChar *replacement = Replacement(c);
+      if (replacement != NULL)
+      {
+        m_text << replacement;
+        m_code << replacement;
+        m_blank = false;
+      }
+      else
+      {
+        m_text << c;
+        if (c == wxT('\n') || c == wxT('\r'))
+          m_code << wxT(' ');
+        else
+          m_code << c;
+        if (!wxIsspace(c))
+          m_blank = false;
+      }
+      i++;
+    }
+  }
+
+  EndStatement(0);
+  // Maxima only answers a terminated statement with a prompt, so input
+  // of nothing but comments and whitespace becomes the empty statement
+  if (!m_lisp && m_statements.IsEmpty())
+    m_command << wxT(";");
+  m_command << wxT("\n");
+}
+
+/***
+ * The current statement ends with terminator, 0 at the end of the input.
+ * Empty statements are dropped with their terminator.
+ */
+void MaximaInput::EndStatement(wxChar terminator)
+{
+  if (!m_blank)
+  {
+    m_statements.Add(m_text.Trim(true).Trim(false));
+    if (!m_lisp)
+      FindDefinition();
+    m_command << m_code;
+    if (terminator != 0)
+      m_command << terminator;
+  }
+
+  m_text = wxEmptyString;
+  m_code = wxEmptyString;
+  m_blank = true;
+}
+
+/***
+ * A statement "name : ..." defines the variable name, a statement
+ * "name(a, [b]) := ..." the function name with the template
+ * "name(<a>,[<b>])".
+ */
+void MaximaInput::FindDefinition()
+{
+  size_t length = m_code.Length();
+  size_t i = 0;
+
+  while (i < length && m_code[i] == wxT(' '))
+    i++;
+  size_t start = i;
+  while (i < length && IsSymbolChar(m_code[i]))
+    i++;
+  if (i == start)
+    return;
+  wxString name = m_code.Mid(start, i - start);
+
+  while (i < length && m_code[i] == wxT(' '))
+    i++;
+  if (i == length)
+    return;
+
+  if (m_code[i] == wxT(':'))
+  {
+    m_symbols.Add(name);
+    return;
+  }
+
+  if (m_code[i] != wxT('('))
+    return;
+
+  // the arguments are symbols and lists of symbols
+  wxArrayString args;
+  wxString arg;
+  for (i++; i < length && m_code[i] != wxT(')'); i++)
+  {
+    wxChar c = m_code[i];
+    if (c == wxT(','))
+    {
+      args.Add(arg);
+      arg = wxEmptyString;
+    }
+    else if (IsSymbolChar(c) || c == wxT('[') || c == wxT(']') ||
+             c == wxT('.') || c == wxT(' '))
+      arg << c;
+    else
+      return;
+  }
+  args.Add(arg);
+
+  for (i++; i < length && m_code[i] == wxT(' '); i++)
+    ;
+  if (i + 1 >= length || m_code[i] != wxT(':') || m_code[i + 1] != wxT('='))
+    return;
+
+  m_symbols.Add(name);
+
+  wxString templ = name + wxT("(");
+  int count = 0;
+  for (size_t j = 0; j < args.GetCount(); j++)
+  {
+    wxString a = args[j].Trim().Trim(false);
+    if (a == wxEmptyString)
+      continue;
+    if (count > 0)
+      templ << wxT(",");
+    if (a[0] == wxT('['))
+      templ << wxT("[<") << a.SubString(1, a.Length() - 2) << wxT(">]");
+    else
+      templ << wxT("<") << a << wxT(">");
+    count++;
+  }
+  templ << wxT(")");
+  m_templates.Add(templ);
+}
@@ -0,0 +1,59 @@
+///
+///  Copyright (C) 2004-2011 Andrej Vodopivec <andrej.vodopivec@gmail.com>
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///
+///  You should have received a copy of the GNU General Public License
+///  along with this program; if not, write to the Free Software
+///  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+///
+
+
+#ifndef _MAXIMAINPUT_H_
+#define _MAXIMAINPUT_H_
+
+#include <wx/wx.h>
+
+/***
+ * MaximaInput reads an input for Maxima in one pass. It rewrites the
+ * Unicode operators wxMaxima shows into Maxima syntax, drops the
+ * comments and the statements which are empty, and splits the input
+ * into statements at terminators outside of strings and comments.
+ * Variables and functions defined by the statements are collected for
+ * autocompletion, with a template for each function.
+ *
+ * Lisp input isn't split, it only gets its operators rewritten.
+ */
+class MaximaInput
+{
+public:
+  MaximaInput(const wxString& input, bool lisp = false);
+  // the input as one line for Maxima
+  const wxString& GetCommand() { return m_command; }
+  // the statements as they were written, for the history
+  const wxArrayString& GetStatements() { return m_statements; }
+  const wxArrayString& GetSymbols() { return m_symbols; }
+  const wxArrayString& GetTemplates() { return m_templates; }
+private:
+  void EndStatement(wxChar terminator);
+  void FindDefinition();
+  bool m_lisp;
+  wxString m_text;   // the current statement as written
+  wxString m_code;   // and without comments, for Maxima
+  bool m_blank;      // the current statement has only spaces and comments
+  wxString m_command;
+  wxArrayString m_statements;
+  wxArrayString m_symbols;
+  wxArrayString m_templates;
+};
+
+#endif //_MAXIMAINPUT_H_
@@ -0,0 +1,238 @@
+///
+///  Copyright (C) 2004-2011 Andrej Vodopivec <andrej.vodopivec@gmail.com>
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///
+///  You should have received a copy of the GNU General Public License
+///  along with this program; if not, write to the Free Software
+///  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+///
+
+
+#include "MaximaStandby.h"
+
+#define STANDBY_FIRST_PROMPT wxT("(%i1) ")
+
+enum {
+  standby_server_id,
+  standby_client_id
+};
+
+MaximaStandby::MaximaStandby()
+{
+  m_server = NULL;
+  m_client = NULL;
+  m_process = NULL;
+  m_processPid = -1;
+  m_pid = -1;
+  m_port = -1;
+  m_ready = false;
+}
+
+MaximaStandby::~MaximaStandby()
+{
+  if (m_client != NULL) {
+    m_client->Notify(false);
+    m_client->Destroy();
+  }
+
+  if (m_process != NULL) {
+    m_process->Detach();
+    wxProcess::Kill(m_pid > 0 ? m_pid : m_processPid, wxSIGKILL);
+  }
+
+  if (m_server != NULL)
+    m_server->Destroy();
+}
+
+/***
+ * Listen on the first free port from port on, return it or -1.
+ */
+int MaximaStandby::Listen(int port)
+{
+  for (m_port = port; m_port < port + 50; m_port++)
+  {
+    wxIPV4address addr;
+#ifndef __WXMAC__
+    addr.LocalHost();
+#else
+    addr.AnyAddress();
+#endif
+    addr.Service(m_port);
+
+    m_server = new wxSocketServer(addr);
+    if (m_server->Ok())
+      break;
+    delete m_server;
+    m_server = NULL;
+  }
+
+  if (m_server == NULL)
+    return -1;
+
+  m_server->SetEventHandler(*this, standby_server_id);
+  m_server->SetNotify(wxSOCKET_CONNECTION_FLAG);
+  m_server->Notify(true);
+
+  return m_port;
+}
+
+/***
+ * Start command, which connects to the port from Listen.
+ */
+bool MaximaStandby::Start(wxString command, const wxArrayString& setup,
+                          wxEvtHandler *processHandler, int processId)
+{
+  m_setup = setup;
+
+  m_process = new wxProcess(processHandler, processId);
+  m_process->Redirect();
+  m_processPid = wxExecute(command, wxEXEC_ASYNC, m_process);
+  if (m_processPid <= 0) {
+    delete m_process;
+    m_process = NULL;
+    return false;
+  }
+
+  return true;
+}
+
+void MaximaStandby::ProcessTerminated()
+{
+  m_process = NULL;
+  m_ready = false;
+}
+
+void MaximaStandby::TakeOver(wxSocketBase **client, wxProcess **process, long *pid, wxString *banner,
+                             std::string *pending)
+{
+  m_client->Notify(false);
+  *client = m_client;
+  *process = m_process;
+  *pid = m_pid;
+  *banner = m_banner;
+  *pending = m_sendQueue;
+  m_sendQueue.clear();
+
+  m_client = NULL;
+  m_process = NULL;
+  m_ready = false;
+}
+
+/***
+ * Queue a command like wxMaxima::SendBytes. What the socket doesn't take
+ * now is written on wxSOCKET_OUTPUT events.
+ */
+void MaximaStandby::Send(wxString command)
+{
+  command.Append(wxT("\n"));
+#if wxUSE_UNICODE
+  wxCharBuffer data = command.utf8_str();
+  m_sendQueue.append(data, strlen(data));
+#else
+  m_sendQueue.append(command.c_str(), command.Length());
+#endif
+  FlushSendQueue();
+}
+
+void MaximaStandby::FlushSendQueue()
+{
+  size_t offset = 0;
+  while (offset < m_sendQueue.size())
+  {
+    m_client->Write(m_sendQueue.data() + offset, m_sendQueue.size() - offset);
+    size_t written = m_client->LastCount();
+    offset += written;
+    if (m_client->Error() || written == 0)
+      break; // the socket is full
+  }
+  m_sendQueue.erase(0, offset);
+}
+
+void MaximaStandby::ServerEvent(wxSocketEvent& event)
+{
+  if (event.GetSocketEvent() != wxSOCKET_CONNECTION)
+    return;
+
+  wxSocketBase *client = m_server->Accept(false);
+  if (m_client != NULL || client == NULL) {
+    if (client != NULL)
+      client->Destroy();
+    return;
+  }
+
+  m_client = client;
+  m_client->SetFlags(wxSOCKET_NOWAIT);
+  m_client->SetEventHandler(*this, standby_client_id);
+  m_client->SetNotify(wxSOCKET_INPUT_FLAG | wxSOCKET_OUTPUT_FLAG | wxSOCKET_LOST_FLAG);
+  m_client->Notify(true);
+
+#ifndef __WXMSW__
+  // the banner with the versions of Maxima and Lisp goes to stdout
+  wxInputStream *input = m_process != NULL ? m_process->GetInputStream() : NULL;
+  while (input != NULL && m_process->IsInputAvailable())
+    m_banner += input->GetC();
+#endif
+}
+
+/***
+ * Wait for the first prompt, then send the setup commands. Maxima works
+ * through them while the standby waits to be taken over.
+ */
+void MaximaStandby::ClientEvent(wxSocketEvent& event)
+{
+  if (m_client == NULL) // taken over
+    return;
+
+  if (event.GetSocketEvent() == wxSOCKET_LOST) {
+    m_client->Destroy();
+    m_client = NULL;
+    m_ready = false;
+    m_sendQueue.clear();
+    return;
+  }
+
+  if (event.GetSocketEvent() == wxSOCKET_OUTPUT) {
+    FlushSendQueue();
+    return;
+  }
+
+  char buffer[1024];
+  m_client->Read(buffer, 1024);
+  if (m_client->Error() || m_ready)
+    return;
+
+  m_decoder.Decode(buffer, m_client->LastCount(), m_output);
+
+  if (m_output.Find(STANDBY_FIRST_PROMPT) == wxNOT_FOUND)
+    return;
+
+  int s = m_output.Find(wxT("pid=")) + 4;
+  int t = s + m_output.SubString(s, m_output.Length()).Find(wxT("\n")) - 1;
+  if (s < t)
+    m_output.SubString(s, t).ToLong(&m_pid);
+
+#if defined __WXMSW__
+  m_banner = m_output;
+#endif
+  m_output = wxEmptyString;
+
+  for (size_t i = 0; i < m_setup.GetCount(); i++)
+    Send(m_setup[i]);
+
+  m_ready = true;
+}
+
+BEGIN_EVENT_TABLE(MaximaStandby, wxEvtHandler)
+  EVT_SOCKET(standby_server_id, MaximaStandby::ServerEvent)
+  EVT_SOCKET(standby_client_id, MaximaStandby::ClientEvent)
+END_EVENT_TABLE()
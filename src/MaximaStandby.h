@@ -0,0 +1,75 @@
+///
+///  Copyright (C) 2004-2011 Andrej Vodopivec <andrej.vodopivec@gmail.com>
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///
+///  You should have received a copy of the GNU General Public License
+///  along with this program; if not, write to the Free Software
+///  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+///
+
+
+#ifndef _MAXIMASTANDBY_H_
+#define _MAXIMASTANDBY_H_
+
+#include <wx/wx.h>
+#include <wx/socket.h>
+#include <wx/process.h>
+
+#include <string>
+
+#include "Utf8Decoder.h"
+
+/***
+ * MaximaStandby starts a spare Maxima on its own port, waits for its
+ * first prompt and sends it the setup commands, so that wxMaxima can
+ * switch to it instead of starting a new Maxima on restart.
+ *
+ * The process events of the spare go to the handler passed to Start.
+ */
+class MaximaStandby : public wxEvtHandler
+{
+public:
+  MaximaStandby();
+  ~MaximaStandby();
+  int Listen(int port);
+  bool Start(wxString command, const wxArrayString& setup,
+             wxEvtHandler *processHandler, int processId);
+  bool IsReady() { return m_ready; }
+  bool IsProcess(long pid) { return m_process != NULL && pid == m_processPid; }
+  void ProcessTerminated();
+  // hand the spare over, the standby forgets about it; pending is the
+  // part of the setup not written to the socket yet
+  void TakeOver(wxSocketBase **client, wxProcess **process, long *pid, wxString *banner,
+                std::string *pending);
+protected:
+  void ServerEvent(wxSocketEvent& event);
+  void ClientEvent(wxSocketEvent& event);
+private:
+  void Send(wxString command);
+  void FlushSendQueue();
+  wxSocketServer *m_server;
+  wxSocketBase *m_client;
+  wxProcess *m_process;
+  long m_processPid;
+  long m_pid;               // of Maxima, from its first prompt
+  int m_port;
+  bool m_ready;
+  wxString m_output;
+  Utf8Decoder m_decoder;
+  wxString m_banner;
+  wxArrayString m_setup;
+  std::string m_sendQueue;  // encoded setup waiting for the socket
+  DECLARE_EVENT_TABLE()
+};
+
+#endif //_MAXIMASTANDBY_H_
@@ -0,0 +1,261 @@
+///
+///  Copyright (C) 2004-2011 Andrej Vodopivec <andrej.vodopivec@gmail.com>
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///
+///  You should have received a copy of the GNU General Public License
+///  along with this program; if not, write to the Free Software
+///  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+///
+
+
+#include "PlainTextCell.h"
+#include "TextCell.h"
+#include "MathParser.h"
+
+PlainTextCell::PlainTextCell() : MathCell()
+{
+  m_longest = 0;
+  m_fontSize = -1;
+  m_charWidth = m_lineHeight = 0;
+  m_textStyle = TS_DEFAULT;
+}
+
+PlainTextCell::~PlainTextCell()
+{
+  if (m_next != NULL)
+    delete m_next;
+}
+
+MathCell* PlainTextCell::Copy(bool all)
+{
+  PlainTextCell *tmp = new PlainTextCell;
+  CopyData(this, tmp);
+  tmp->m_bigSkip = m_bigSkip;
+  tmp->m_lines = m_lines;
+  tmp->m_xml = m_xml;
+  tmp->m_longest = m_longest;
+  if (all && m_next != NULL)
+    tmp->AppendCell(m_next->Copy(all));
+  return tmp;
+}
+
+void PlainTextCell::Destroy()
+{
+  m_next = NULL;
+}
+
+void PlainTextCell::AppendLine(const wxString& text, const wxString& xml)
+{
+  wxString line(text);
+  line.Replace(wxT("\t"), wxT("        "));
+  m_lines.Add(line);
+  m_xml.Add(xml);
+  m_longest = MAX(m_longest, line.Length());
+  ResetSize();
+}
+
+void PlainTextCell::AppendLines(PlainTextCell *cell)
+{
+  for (size_t i = 0; i < cell->m_lines.GetCount(); i++)
+    AppendLine(cell->m_lines[i], cell->m_xml[i]);
+}
+
+/***
+ * Remove the first count lines.
+ */
+void PlainTextCell::RemoveLines(size_t count)
+{
+  count = MIN(count, m_lines.GetCount());
+  m_lines.RemoveAt(0, count);
+  m_xml.RemoveAt(0, count);
+  m_longest = 0;
+  for (size_t i = 0; i < m_lines.GetCount(); i++)
+    m_longest = MAX(m_longest, m_lines[i].Length());
+  ResetSize();
+}
+
+/***
+ * Make the cells this text stands for: the parsed xml of the lines
+ * which have it and a TextCell for each raw line. The caller owns the
+ * returned cells.
+ */
+MathCell* PlainTextCell::ToCells()
+{
+  MathParser parser;
+  MathCell *cells = NULL, *last = NULL;
+  size_t count = m_lines.GetCount();
+
+  for (size_t i = 0; i < count; i++)
+  {
+    MathCell *line;
+    if (m_xml[i].Length())
+      line = parser.ParseXml(wxT("<span><mth>") + m_xml[i] + wxT("</mth></span>"), m_type);
+    else
+    {
+      line = new TextCell(m_lines[i]);
+      line->SetType(m_type);
+      if (i + 1 < count)
+        line->SetSkip(false);
+    }
+    if (line == NULL)
+      continue;
+
+    line->ForceBreakLine(true);
+    if (cells == NULL)
+      cells = line;
+    else
+      last->AppendCell(line);
+    last = line;
+    while (last->m_next != NULL)
+      last = last->m_next;
+  }
+
+  if (cells != NULL)
+    cells->ForceBreakLine(m_forceBreakLine);
+  return cells;
+}
+
+void PlainTextCell::RecalculateWidths(CellParser& parser, int fontsize, bool all)
+{
+  if (m_height == -1 || m_width == -1 || fontsize != m_fontSize || parser.ForceUpdate())
+  {
+    m_fontSize = fontsize;
+
+    double scale = parser.GetScale();
+    int padding = SCALE_PX(MC_TEXT_PADDING, scale);
+    SetFont(parser, fontsize);
+    parser.GetDC().GetTextExtent(wxT("X"), &m_charWidth, &m_lineHeight);
+
+    m_width = m_charWidth * int(m_longest) + 2 * padding;
+    m_height = m_lineHeight * m_lines.GetCount() + 2 * padding;
+    m_center = padding + m_lineHeight / 2;
+  }
+  MathCell::RecalculateWidths(parser, fontsize, all);
+}
+
+void PlainTextCell::RecalculateSize(CellParser& parser, int fontsize, bool all)
+{
+  MathCell::RecalculateSize(parser, fontsize, all);
+}
+
+/***
+ * Only the lines and the columns inside the bounds of the parser are
+ * drawn - all lines have the same height and all characters the same
+ * width.
+ */
+void PlainTextCell::Draw(CellParser& parser, wxPoint point, int fontsize, bool all)
+{
+  if (m_width == -1 || m_height == -1)
+    RecalculateWidths(parser, fontsize, false);
+
+  if (DrawThisCell(parser, point) && m_lineHeight > 0 && m_charWidth > 0)
+  {
+    wxDC& dc = parser.GetDC();
+    double scale = parser.GetScale();
+    int padding = SCALE_PX(MC_TEXT_PADDING, scale);
+    int x = point.x + padding;
+    int y = point.y - m_center + padding;
+
+    int first = 0, last = m_lines.GetCount() - 1;
+    if (parser.GetTop() != -1 && parser.GetBottom() != -1)
+    {
+      first = MAX(first, (parser.GetTop() - y) / m_lineHeight);
+      last = MIN(last, (parser.GetBottom() - y) / m_lineHeight);
+    }
+
+    int from = 0, length = -1;
+    if (parser.GetLeft() != -1 && parser.GetRight() != -1)
+    {
+      from = MAX(0, (parser.GetLeft() - x) / m_charWidth);
+      length = MAX(0, (parser.GetRight() - x) / m_charWidth + 1 - from);
+    }
+
+    SetFont(parser, fontsize);
+    SetForeground(parser);
+
+    for (int i = first; i <= last; i++)
+    {
+      if (from == 0 && length == -1)
+        dc.DrawText(m_lines[i], x, y + i * m_lineHeight);
+      else if (size_t(from) < m_lines[i].Length())
+        dc.DrawText(m_lines[i].Mid(from, length), x + from * m_charWidth,
+                    y + i * m_lineHeight);
+    }
+  }
+  MathCell::Draw(parser, point, fontsize, all);
+}
+
+void PlainTextCell::SetFont(CellParser& parser, int fontsize)
+{
+  double scale = parser.GetScale();
+  int fontsize1 = (int) (((double)fontsize) * scale + 0.5);
+  fontsize1 = MAX(fontsize1, 1);
+
+  parser.GetDC().SetFont(wxFont(fontsize1, wxFONTFAMILY_MODERN,
+                                wxFONTSTYLE_NORMAL,
+                                wxFONTWEIGHT_NORMAL,
+                                false,
+                                wxEmptyString,
+                                parser.GetFontEncoding()));
+}
+
+wxString PlainTextCell::ToString(bool all)
+{
+  wxString text;
+  for (size_t i = 0; i < m_lines.GetCount(); i++)
+  {
+    if (i > 0)
+      text += wxT("\n");
+    text += m_lines[i];
+  }
+  return text + MathCell::ToString(all);
+}
+
+wxString PlainTextCell::ToTeX(bool all)
+{
+  wxString text;
+  MathCell *cells = ToCells();
+  if (cells != NULL)
+    text = cells->ToTeX(true);
+  while (cells != NULL)
+  {
+    MathCell *tmp = cells;
+    cells = cells->m_next;
+    tmp->Destroy();
+    delete tmp;
+  }
+  return text + MathCell::ToTeX(all);
+}
+
+wxString PlainTextCell::ToXML(bool all)
+{
+  wxString xml;
+  for (size_t i = 0; i < m_lines.GetCount(); i++)
+  {
+    if (i > 0)
+      xml += wxT("</mth>\n<mth>");
+    if (m_xml[i].Length())
+      xml += m_xml[i];
+    else
+    {
+      wxString text(m_lines[i]);
+      text.Replace(wxT("&"),  wxT("&amp;"));
+      text.Replace(wxT("<"),  wxT("&lt;"));
+      text.Replace(wxT(">"),  wxT("&gt;"));
+      text.Replace(wxT("'"),  wxT("&apos;"));
+      text.Replace(wxT("\""), wxT("&quot;"));
+      xml += wxT("<t>") + text + wxT("</t>");
+    }
+  }
+  return xml + MathCell::ToXML(all);
+}
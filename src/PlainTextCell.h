@@ -0,0 +1,60 @@
+///
+///  Copyright (C) 2004-2011 Andrej Vodopivec <andrej.vodopivec@gmail.com>
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///
+///  You should have received a copy of the GNU General Public License
+///  along with this program; if not, write to the Free Software
+///  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+///
+
+
+#ifndef _PLAINTEXTCELL_H_
+#define _PLAINTEXTCELL_H_
+
+#include "MathCell.h"
+
+/***
+ * PlainTextCell shows output as lines of monospaced text, without a
+ * cell and a layout for every token. Consecutive lines of output go
+ * into one cell and only the visible lines are drawn. Lines which came
+ * as xml keep it, so the cell can be turned back into 2D math and is
+ * saved the same way as the cells it stands for.
+ */
+class PlainTextCell : public MathCell
+{
+public:
+  PlainTextCell();
+  ~PlainTextCell();
+  MathCell* Copy(bool all);
+  void Destroy();
+  void AppendLine(const wxString& text, const wxString& xml = wxEmptyString);
+  void AppendLines(PlainTextCell *cell);
+  void RemoveLines(size_t count);
+  size_t GetLineCount() { return m_lines.GetCount(); }
+  MathCell* ToCells();
+  void RecalculateWidths(CellParser& parser, int fontsize, bool all);
+  void RecalculateSize(CellParser& parser, int fontsize, bool all);
+  void Draw(CellParser& parser, wxPoint point, int fontsize, bool all);
+  wxString ToString(bool all);
+  wxString ToTeX(bool all);
+  wxString ToXML(bool all);
+private:
+  void SetFont(CellParser& parser, int fontsize);
+  wxArrayString m_lines;
+  wxArrayString m_xml;  // xml of each line, empty for raw text
+  size_t m_longest;     // characters in the longest line
+  int m_fontSize;
+  int m_charWidth, m_lineHeight;
+};
+
+#endif //_PLAINTEXTCELL_H_
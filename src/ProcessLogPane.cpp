@@ -0,0 +1,89 @@
+///
+///  Copyright (C) 2004-2011 Andrej Vodopivec <andrej.vodopivec@gmail.com>
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///
+///  You should have received a copy of the GNU General Public License
+///  along with this program; if not, write to the Free Software
+///  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+///
+
+
+#include "ProcessLogPane.h"
+
+#include <wx/sizer.h>
+
+#define PROCESS_LOG_UPDATE 1000
+
+ProcessLogPane::ProcessLogPane(wxWindow* parent, int id, ProcessOutput *out, ProcessOutput *err) :
+  wxPanel(parent, id)
+{
+  m_out = out;
+  m_err = err;
+
+  m_log = new wxTextCtrl(this, process_log_text_id, wxEmptyString, wxDefaultPosition,
+                         wxSize(300, 200), wxTE_MULTILINE | wxTE_READONLY | wxTE_DONTWRAP);
+  m_log->SetFont(wxFont(10, wxFONTFAMILY_MODERN, wxFONTSTYLE_NORMAL, wxFONTWEIGHT_NORMAL));
+
+  m_counters = new wxStaticText(this, -1, wxEmptyString);
+
+  wxFlexGridSizer * box = new wxFlexGridSizer(1);
+  box->AddGrowableCol(0);
+  box->AddGrowableRow(0);
+
+  box->Add(m_log, 0, wxEXPAND | wxALL, 0);
+  box->Add(m_counters, 0, wxEXPAND | wxALL, 2);
+  box->Add(new wxButton(this, process_log_clear_id, _("Clear")), 0, wxALL, 1);
+
+  SetSizer(box);
+  box->Fit(this);
+  box->SetSizeHints(this);
+
+  m_timer.SetOwner(this, process_log_timer_id);
+  m_timer.Start(PROCESS_LOG_UPDATE);
+}
+
+void ProcessLogPane::UpdateDisplay()
+{
+  unsigned long outBytes, outLines, outDropped;
+  unsigned long errBytes, errLines, errDropped;
+  m_out->GetCounters(&outBytes, &outLines, &outDropped);
+  m_err->GetCounters(&errBytes, &errLines, &errDropped);
+
+  m_counters->SetLabel(wxString::Format(_("stdout: %lu lines, %lu bytes\n"
+                                          "stderr: %lu lines, %lu bytes, %lu not kept"),
+                                        outLines, outBytes, errLines, errBytes, errDropped));
+
+  if (m_err->HasChanged())
+  {
+    m_log->SetValue(m_err->GetRecent());
+    m_log->ShowPosition(m_log->GetLastPosition());
+  }
+}
+
+void ProcessLogPane::OnClear(wxCommandEvent &ev)
+{
+  m_out->Clear();
+  m_err->Clear();
+  UpdateDisplay();
+}
+
+void ProcessLogPane::OnTimer(wxTimerEvent &ev)
+{
+  if (IsShown())
+    UpdateDisplay();
+}
+
+BEGIN_EVENT_TABLE(ProcessLogPane, wxPanel)
+  EVT_BUTTON(process_log_clear_id, ProcessLogPane::OnClear)
+  EVT_TIMER(process_log_timer_id, ProcessLogPane::OnTimer)
+END_EVENT_TABLE()
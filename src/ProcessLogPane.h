@@ -0,0 +1,55 @@
+///
+///  Copyright (C) 2004-2011 Andrej Vodopivec <andrej.vodopivec@gmail.com>
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///
+///  You should have received a copy of the GNU General Public License
+///  along with this program; if not, write to the Free Software
+///  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+///
+
+
+#include <wx/wx.h>
+#include <wx/timer.h>
+
+#include "ProcessReader.h"
+
+#ifndef PROCESSLOGPANE_H
+#define PROCESSLOGPANE_H
+
+enum {
+  process_log_text_id,
+  process_log_clear_id,
+  process_log_timer_id
+};
+
+/***
+ * The Maxima Process pane shows the recent stderr output of Maxima (and
+ * of gnuplot, which writes to the same pipe) and how much was written to
+ * stdout and stderr.
+ */
+class ProcessLogPane : public wxPanel
+{
+public:
+  ProcessLogPane(wxWindow* parent, int id, ProcessOutput *out, ProcessOutput *err);
+  void UpdateDisplay();
+  void OnClear(wxCommandEvent &ev);
+  void OnTimer(wxTimerEvent &ev);
+private:
+  ProcessOutput *m_out, *m_err;
+  wxTextCtrl *m_log;
+  wxStaticText *m_counters;
+  wxTimer m_timer;
+  DECLARE_EVENT_TABLE()
+};
+
+#endif
@@ -0,0 +1,195 @@
+///
+///  Copyright (C) 2004-2011 Andrej Vodopivec <andrej.vodopivec@gmail.com>
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///
+///  You should have received a copy of the GNU General Public License
+///  along with this program; if not, write to the Free Software
+///  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+///
+
+
+#include "ProcessReader.h"
+#include "Utf8Decoder.h"
+
+#include <string.h>
+
+ProcessOutput::ProcessOutput() : m_ring(PROCESS_OUTPUT_SIZE)
+{
+  m_start = m_length = 0;
+  m_bytes = m_lines = m_dropped = 0;
+  m_changed = false;
+}
+
+void ProcessOutput::Append(const char *data, size_t length)
+{
+  wxCriticalSectionLocker lock(m_lock);
+
+  m_bytes += length;
+  for (size_t i = 0; i < length; i++)
+    if (data[i] == '\n')
+      m_lines++;
+
+  // only the end of a long piece fits
+  if (length > PROCESS_OUTPUT_SIZE)
+  {
+    m_dropped += length - PROCESS_OUTPUT_SIZE;
+    data += length - PROCESS_OUTPUT_SIZE;
+    length = PROCESS_OUTPUT_SIZE;
+  }
+
+  if (m_length + length > PROCESS_OUTPUT_SIZE)
+  {
+    size_t drop = m_length + length - PROCESS_OUTPUT_SIZE;
+    m_start = (m_start + drop) % PROCESS_OUTPUT_SIZE;
+    m_length -= drop;
+    m_dropped += drop;
+  }
+
+  size_t end = (m_start + m_length) % PROCESS_OUTPUT_SIZE;
+  size_t first = wxMin(length, PROCESS_OUTPUT_SIZE - end);
+  memcpy(&m_ring[end], data, first);
+  memcpy(&m_ring[0], data + first, length - first);
+  m_length += length;
+  m_changed = true;
+}
+
+void ProcessOutput::Clear()
+{
+  wxCriticalSectionLocker lock(m_lock);
+  m_start = m_length = 0;
+  m_bytes = m_lines = m_dropped = 0;
+  m_changed = true;
+}
+
+/***
+ * The output kept in the ring. wxStrings are not shared between threads,
+ * so the bytes are copied under the lock and decoded after it.
+ */
+wxString ProcessOutput::GetRecent()
+{
+  std::vector<char> bytes;
+  {
+    wxCriticalSectionLocker lock(m_lock);
+    bytes.resize(m_length);
+    size_t first = wxMin(m_length, PROCESS_OUTPUT_SIZE - m_start);
+    if (first > 0)
+      memcpy(&bytes[0], &m_ring[m_start], first);
+    if (m_length > first)
+      memcpy(&bytes[first], &m_ring[0], m_length - first);
+    m_changed = false;
+  }
+
+  wxString text;
+  Utf8Decoder decoder;
+  if (!bytes.empty())
+    decoder.Decode(&bytes[0], bytes.size(), text);
+  return text;
+}
+
+bool ProcessOutput::HasChanged()
+{
+  wxCriticalSectionLocker lock(m_lock);
+  return m_changed;
+}
+
+void ProcessOutput::GetCounters(unsigned long *bytes, unsigned long *lines, unsigned long *dropped)
+{
+  wxCriticalSectionLocker lock(m_lock);
+  *bytes = m_bytes;
+  *lines = m_lines;
+  *dropped = m_dropped;
+}
+
+ProcessReader::ProcessReader(wxProcess *process, ProcessOutput *out, ProcessOutput *err) :
+  wxThread(wxTHREAD_JOINABLE)
+{
+  m_stdout = process->GetInputStream();
+  m_stderr = process->GetErrorStream();
+  m_out = out;
+  m_err = err;
+  m_stop = false;
+}
+
+/***
+ * Read what the pipe has now, at most PROCESS_OUTPUT_SIZE bytes so that
+ * a busy pipe doesn't keep the other one waiting. Returns true if
+ * something was read.
+ */
+bool ProcessReader::Drain(wxInputStream *stream, ProcessOutput *output)
+{
+  if (stream == NULL || stream->Eof())
+    return false;
+
+  char buffer[PROCESS_READ_SIZE];
+  size_t total = 0;
+  // Read returns what is there once it has some bytes
+  while (total < PROCESS_OUTPUT_SIZE && stream->CanRead())
+  {
+    stream->Read(buffer, PROCESS_READ_SIZE);
+    size_t read = stream->LastRead();
+    if (read == 0)
+      break;
+    output->Append(buffer, read);
+    total += read;
+  }
+
+  return total > 0;
+}
+
+/***
+ * Read what both pipes have now. Called from the GUI thread when it
+ * needs the output up to this moment.
+ */
+void ProcessReader::Drain()
+{
+  wxCriticalSectionLocker lock(m_streamLock);
+  Drain(m_stdout, m_out);
+  Drain(m_stderr, m_err);
+}
+
+bool ProcessReader::IsStopped()
+{
+  wxCriticalSectionLocker lock(m_stopLock);
+  return m_stop;
+}
+
+/***
+ * End the thread and wait for it.
+ */
+void ProcessReader::Stop()
+{
+  {
+    wxCriticalSectionLocker lock(m_stopLock);
+    m_stop = true;
+  }
+  Wait();
+}
+
+wxThread::ExitCode ProcessReader::Entry()
+{
+  while (!IsStopped())
+  {
+    bool readSome;
+    {
+      wxCriticalSectionLocker lock(m_streamLock);
+      readSome = Drain(m_stdout, m_out);
+      readSome = Drain(m_stderr, m_err) || readSome;
+      if ((m_stdout == NULL || m_stdout->Eof()) &&
+          (m_stderr == NULL || m_stderr->Eof()))
+        break;
+    }
+    if (!readSome)
+      Sleep(PROCESS_READER_SLEEP);
+  }
+  return 0;
+}
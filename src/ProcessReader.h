@@ -0,0 +1,82 @@
+///
+///  Copyright (C) 2004-2011 Andrej Vodopivec <andrej.vodopivec@gmail.com>
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///
+///  You should have received a copy of the GNU General Public License
+///  along with this program; if not, write to the Free Software
+///  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+///
+
+
+#ifndef _PROCESSREADER_H_
+#define _PROCESSREADER_H_
+
+#include <wx/wx.h>
+#include <wx/thread.h>
+#include <wx/process.h>
+#include <vector>
+
+#define PROCESS_OUTPUT_SIZE 65536 // bytes of recent output kept per pipe
+#define PROCESS_READ_SIZE 4096
+#define PROCESS_READER_SLEEP 20   // ms between looks at idle pipes
+
+/***
+ * The recent output of one pipe of the Maxima process, in a ring buffer
+ * of PROCESS_OUTPUT_SIZE bytes, and counters of all of it. The reader
+ * thread appends to it, the GUI thread reads it.
+ */
+class ProcessOutput
+{
+public:
+  ProcessOutput();
+  void Append(const char *data, size_t length);
+  void Clear();
+  wxString GetRecent();
+  bool HasChanged();  // since the last GetRecent
+  void GetCounters(unsigned long *bytes, unsigned long *lines, unsigned long *dropped);
+private:
+  wxCriticalSection m_lock;
+  std::vector<char> m_ring;
+  size_t m_start, m_length;
+  unsigned long m_bytes, m_lines;
+  unsigned long m_dropped; // bytes which didn't fit in the ring any more
+  bool m_changed;
+};
+
+/***
+ * ProcessReader empties the stdout and stderr pipes of a redirected
+ * process into ProcessOutputs, so that a process writing a lot there
+ * never waits for wxMaxima. Reads don't block: idle pipes are looked at
+ * every PROCESS_READER_SLEEP ms. The thread ends when both pipes are
+ * closed or Stop is called, which has to be done before the process
+ * (which owns the streams) is deleted.
+ */
+class ProcessReader : public wxThread
+{
+public:
+  ProcessReader(wxProcess *process, ProcessOutput *out, ProcessOutput *err);
+  void Drain();
+  void Stop();
+protected:
+  ExitCode Entry();
+private:
+  bool Drain(wxInputStream *stream, ProcessOutput *output);
+  bool IsStopped();
+  wxInputStream *m_stdout, *m_stderr;
+  ProcessOutput *m_out, *m_err;
+  wxCriticalSection m_streamLock; // the GUI thread may drain too
+  wxCriticalSection m_stopLock;
+  bool m_stop;
+};
+
+#endif //_PROCESSREADER_H_
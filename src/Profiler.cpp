@@ -0,0 +1,165 @@
+///
+///  Copyright (C) 2004-2011 Andrej Vodopivec <andrej.vodopivec@gmail.com>
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///
+///  You should have received a copy of the GNU General Public License
+///  along with this program; if not, write to the Free Software
+///  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+///
+
+
+#include "Profiler.h"
+
+#include <wx/file.h>
+#include <wx/stopwatch.h>
+#include <wx/thread.h>
+
+std::vector<ProfilerEvent> Profiler::m_events;
+size_t Profiler::m_next = 0;
+ProfilerPhases Profiler::m_phases;
+long Profiler::m_stalls = 0;
+double Profiler::m_longestStall = 0;
+double Profiler::m_lastHeartbeat = -1;
+
+static wxStopWatch profilerClock;
+
+/***
+ * The stall monitor ticks every PROFILER_HEARTBEAT ms when the event loop
+ * runs. A late tick means something blocked the loop.
+ */
+class StallMonitor : public wxTimer
+{
+public:
+  void Notify() { Profiler::Heartbeat(); }
+};
+
+static StallMonitor *stallMonitor = NULL;
+
+double Profiler::Now()
+{
+#if wxCHECK_VERSION(2,9,0)
+  return profilerClock.TimeInMicro().ToDouble() / 1000.0;
+#else
+  return profilerClock.Time();
+#endif
+}
+
+void Profiler::Add(const wxChar *phase, double start, double duration)
+{
+#if wxUSE_THREADS
+  if (!wxThread::IsMain())
+    return;
+#endif
+
+  ProfilerEvent event = { phase, start, duration };
+  if (m_events.size() < PROFILER_MAX_EVENTS)
+    m_events.push_back(event);
+  else {
+    m_events[m_next] = event;
+    m_next = (m_next + 1) % PROFILER_MAX_EVENTS;
+  }
+
+  ProfilerPhase& stats = m_phases[phase];
+  stats.count++;
+  stats.total += duration;
+  if (duration > stats.max)
+    stats.max = duration;
+}
+
+void Profiler::StartStallMonitor()
+{
+  if (stallMonitor != NULL)
+    return;
+  stallMonitor = new StallMonitor();
+  stallMonitor->Start(PROFILER_HEARTBEAT);
+}
+
+void Profiler::StopStallMonitor()
+{
+  if (stallMonitor == NULL)
+    return;
+  stallMonitor->Stop();
+  delete stallMonitor;
+  stallMonitor = NULL;
+}
+
+void Profiler::Heartbeat()
+{
+  double now = Now();
+
+  if (m_lastHeartbeat >= 0)
+  {
+    double blocked = now - m_lastHeartbeat - PROFILER_HEARTBEAT;
+    if (blocked > PROFILER_STALL_THRESHOLD)
+    {
+      m_stalls++;
+      if (blocked > m_longestStall)
+        m_longestStall = blocked;
+      Add(wxT("stall"), m_lastHeartbeat + PROFILER_HEARTBEAT, blocked);
+    }
+  }
+
+  m_lastHeartbeat = now;
+}
+
+void Profiler::Reset()
+{
+  m_events.clear();
+  m_next = 0;
+  m_phases.clear();
+  m_stalls = 0;
+  m_longestStall = 0;
+}
+
+wxString Profiler::GetSummary()
+{
+  wxString summary = wxString::Format(wxT("%-16s %8s %12s %10s %10s\n"),
+      wxT("phase"), wxT("calls"), wxT("total[ms]"), wxT("mean[ms]"), wxT("max[ms]"));
+
+  for (ProfilerPhases::iterator it = m_phases.begin(); it != m_phases.end(); ++it)
+    summary += wxString::Format(wxT("%-16s %8ld %12.1f %10.2f %10.1f\n"),
+        it->first.c_str(), it->second.count, it->second.total,
+        it->second.total / it->second.count, it->second.max);
+
+  summary += wxString::Format(wxT("\n%ld stalls over %d ms, longest %.0f ms\n"),
+      m_stalls, PROFILER_STALL_THRESHOLD, m_longestStall);
+
+  return summary;
+}
+
+/***
+ * Write the recorded events in the Chrome trace event format, which
+ * chrome://tracing and other trace viewers open.
+ */
+bool Profiler::WriteTrace(wxString file)
+{
+  wxFile output;
+  if (!output.Create(file, true))
+    return false;
+
+  wxString trace = wxT("{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+
+  for (size_t i = 0; i < m_events.size(); i++)
+  {
+    // oldest first once the buffer wrapped around
+    ProfilerEvent& event = m_events[(m_next + i) % m_events.size()];
+    trace += wxString::Format(
+        wxT("{\"name\": \"%s\", \"cat\": \"wxmaxima\", \"ph\": \"X\", \"ts\": %.0f, \"dur\": %.0f, \"pid\": 1, \"tid\": 1}%s\n"),
+        event.phase, event.start * 1000, event.duration * 1000,
+        i + 1 < m_events.size() ? wxT(",") : wxT(""));
+  }
+
+  trace += wxT("]}\n");
+
+  return output.Write(trace, wxConvUTF8);
+}
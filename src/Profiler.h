@@ -0,0 +1,94 @@
+///
+///  Copyright (C) 2004-2011 Andrej Vodopivec <andrej.vodopivec@gmail.com>
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///
+///  You should have received a copy of the GNU General Public License
+///  along with this program; if not, write to the Free Software
+///  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+///
+
+
+#ifndef _PROFILER_H_
+#define _PROFILER_H_
+
+#include <wx/wx.h>
+#include <wx/hashmap.h>
+#include <wx/timer.h>
+#include <vector>
+
+#define PROFILER_MAX_EVENTS 50000   // the trace keeps the latest events
+#define PROFILER_STALL_THRESHOLD 250 // ms the event loop may be blocked
+#define PROFILER_HEARTBEAT 100       // ms between stall monitor ticks
+
+struct ProfilerEvent
+{
+  const wxChar *phase;
+  double start;      // ms since the program started
+  double duration;   // ms
+};
+
+struct ProfilerPhase
+{
+  ProfilerPhase() : count(0), total(0), max(0) { }
+  long count;
+  double total, max; // ms
+};
+
+WX_DECLARE_STRING_HASH_MAP(ProfilerPhase, ProfilerPhases);
+
+/***
+ * Profiler collects the time spent in the phases of wxMaxima marked with
+ * PROFILE_SCOPE and the times the event loop was blocked. It is always
+ * compiled in; a scope costs two clock reads.
+ *
+ * Only scopes in the GUI thread are recorded.
+ */
+class Profiler
+{
+public:
+  static double Now();
+  static void Add(const wxChar *phase, double start, double duration);
+  static void StartStallMonitor();
+  static void StopStallMonitor();
+  static void Heartbeat();
+  static void Reset();
+  static const ProfilerPhases& GetPhases() { return m_phases; }
+  static long GetStalls() { return m_stalls; }
+  static double GetLongestStall() { return m_longestStall; }
+  static wxString GetSummary();
+  static bool WriteTrace(wxString file);
+private:
+  static std::vector<ProfilerEvent> m_events;
+  static size_t m_next;      // where the next event goes once m_events is full
+  static ProfilerPhases m_phases;
+  static long m_stalls;
+  static double m_longestStall;
+  static double m_lastHeartbeat;
+};
+
+/***
+ * Times the enclosing block as one event of phase.
+ */
+class ProfileScope
+{
+public:
+  ProfileScope(const wxChar *phase) : m_phase(phase), m_start(Profiler::Now()) { }
+  ~ProfileScope() { Profiler::Add(m_phase, m_start, Profiler::Now() - m_start); }
+private:
+  const wxChar *m_phase;
+  double m_start;
+};
+
+#define PROFILE_SCOPE(phase) ProfileScope profileScope(wxT(phase))
+
+#endif //_PROFILER_H_
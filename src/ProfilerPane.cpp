@@ -0,0 +1,113 @@
+///
+///  Copyright (C) 2004-2011 Andrej Vodopivec <andrej.vodopivec@gmail.com>
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///
+///  You should have received a copy of the GNU General Public License
+///  along with this program; if not, write to the Free Software
+///  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+///
+
+
+#include "ProfilerPane.h"
+#include "Profiler.h"
+
+#include <wx/sizer.h>
+#include <wx/filedlg.h>
+
+#define PROFILER_PANE_UPDATE 1000
+
+ProfilerPane::ProfilerPane(wxWindow* parent, int id) : wxPanel(parent, id)
+{
+  m_phases = new wxListCtrl(this, profiler_list_id, wxDefaultPosition, wxDefaultSize,
+                            wxLC_REPORT | wxLC_SINGLE_SEL);
+  m_phases->InsertColumn(0, _("Phase"));
+  m_phases->InsertColumn(1, _("Calls"), wxLIST_FORMAT_RIGHT);
+  m_phases->InsertColumn(2, _("Total [ms]"), wxLIST_FORMAT_RIGHT);
+  m_phases->InsertColumn(3, _("Mean [ms]"), wxLIST_FORMAT_RIGHT);
+  m_phases->InsertColumn(4, _("Max [ms]"), wxLIST_FORMAT_RIGHT);
+
+  m_stalls = new wxStaticText(this, -1, wxEmptyString);
+
+  wxBoxSizer *buttons = new wxBoxSizer(wxHORIZONTAL);
+  buttons->Add(new wxButton(this, profiler_export_id, _("Export Trace...")), 0, wxALL, 1);
+  buttons->Add(new wxButton(this, profiler_reset_id, _("Reset")), 0, wxALL, 1);
+
+  wxFlexGridSizer * box = new wxFlexGridSizer(1);
+  box->AddGrowableCol(0);
+  box->AddGrowableRow(0);
+
+  box->Add(m_phases, 0, wxEXPAND | wxALL, 0);
+  box->Add(m_stalls, 0, wxEXPAND | wxALL, 2);
+  box->Add(buttons, 0, wxALL, 0);
+
+  SetSizer(box);
+  box->Fit(this);
+  box->SetSizeHints(this);
+
+  m_timer.SetOwner(this, profiler_timer_id);
+  m_timer.Start(PROFILER_PANE_UPDATE);
+}
+
+void ProfilerPane::UpdateDisplay()
+{
+  const ProfilerPhases& phases = Profiler::GetPhases();
+
+  m_phases->Freeze();
+  m_phases->DeleteAllItems();
+
+  long row = 0;
+  for (ProfilerPhases::const_iterator it = phases.begin(); it != phases.end(); ++it, ++row)
+  {
+    const ProfilerPhase& phase = it->second;
+    m_phases->InsertItem(row, it->first);
+    m_phases->SetItem(row, 1, wxString::Format(wxT("%ld"), phase.count));
+    m_phases->SetItem(row, 2, wxString::Format(wxT("%.1f"), phase.total));
+    m_phases->SetItem(row, 3, wxString::Format(wxT("%.2f"), phase.total / phase.count));
+    m_phases->SetItem(row, 4, wxString::Format(wxT("%.1f"), phase.max));
+  }
+
+  m_phases->Thaw();
+
+  m_stalls->SetLabel(wxString::Format(_("%ld stalls, longest %.0f ms"),
+                                      Profiler::GetStalls(), Profiler::GetLongestStall()));
+}
+
+void ProfilerPane::OnExport(wxCommandEvent &ev)
+{
+  wxString file = wxFileSelector(_("Export trace"), wxEmptyString, wxT("wxmaxima-trace.json"),
+                                 wxT("json"), _("Chrome trace (*.json)|*.json"),
+                                 wxFD_SAVE | wxFD_OVERWRITE_PROMPT, this);
+  if (file.Length() == 0)
+    return;
+
+  if (!Profiler::WriteTrace(file))
+    wxMessageBox(_("Exporting the trace failed."), _("Error"), wxOK | wxICON_ERROR);
+}
+
+void ProfilerPane::OnReset(wxCommandEvent &ev)
+{
+  Profiler::Reset();
+  UpdateDisplay();
+}
+
+void ProfilerPane::OnTimer(wxTimerEvent &ev)
+{
+  if (IsShown())
+    UpdateDisplay();
+}
+
+BEGIN_EVENT_TABLE(ProfilerPane, wxPanel)
+  EVT_BUTTON(profiler_export_id, ProfilerPane::OnExport)
+  EVT_BUTTON(profiler_reset_id, ProfilerPane::OnReset)
+  EVT_TIMER(profiler_timer_id, ProfilerPane::OnTimer)
+END_EVENT_TABLE()
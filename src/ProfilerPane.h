@@ -0,0 +1,54 @@
+///
+///  Copyright (C) 2004-2011 Andrej Vodopivec <andrej.vodopivec@gmail.com>
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///
+///  You should have received a copy of the GNU General Public License
+///  along with this program; if not, write to the Free Software
+///  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+///
+
+
+#include <wx/wx.h>
+#include <wx/listctrl.h>
+#include <wx/timer.h>
+
+#ifndef PROFILERPANE_H
+#define PROFILERPANE_H
+
+enum {
+  profiler_list_id,
+  profiler_export_id,
+  profiler_reset_id,
+  profiler_timer_id
+};
+
+/***
+ * The Profiler pane shows the time spent in every phase and the event
+ * loop stalls recorded by Profiler, and exports them as a trace.
+ */
+class ProfilerPane : public wxPanel
+{
+public:
+  ProfilerPane(wxWindow* parent, int id);
+  void UpdateDisplay();
+  void OnExport(wxCommandEvent &ev);
+  void OnReset(wxCommandEvent &ev);
+  void OnTimer(wxTimerEvent &ev);
+private:
+  wxListCtrl *m_phases;
+  wxStaticText *m_stalls;
+  wxTimer m_timer;
+  DECLARE_EVENT_TABLE()
+};
+
+#endif
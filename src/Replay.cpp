@@ -0,0 +1,224 @@
+///
+///  Copyright (C) 2004-2011 Andrej Vodopivec <andrej.vodopivec@gmail.com>
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///
+///  You should have received a copy of the GNU General Public License
+///  along with this program; if not, write to the Free Software
+///  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+///
+
+
+/***
+ * wxmaxima-replay stands in for Maxima: it connects to wxMaxima's socket
+ * server and plays back a transcript recorded with WXMAXIMA_TRANSCRIPT,
+ * at the recorded speed or as fast as possible (--fast). Output from
+ * Maxima is only sent after wxMaxima has sent the input it answers.
+ *
+ * It can be started by hand with --port, or by wxMaxima itself when the
+ * Maxima program is set to wxmaxima-replay and WXMAXIMA_REPLAY names the
+ * transcript; it understands the arguments wxMaxima passes to Maxima.
+ *
+ * At the end it reports throughput and the turnaround time: the time from
+ * the last output of an answer to the next input, which includes parsing
+ * and displaying the answer in wxMaxima.
+ */
+
+#include <wx/wx.h>
+#include <wx/app.h>
+#include <wx/cmdline.h>
+#include <wx/regex.h>
+#include <wx/socket.h>
+#include <wx/stopwatch.h>
+#include <wx/utils.h>
+
+#include "Transcript.h"
+
+#include <stdio.h>
+
+#define REPLAY_INPUT_TIMEOUT 60 // s to wait for input from wxMaxima
+
+class ReplayApp : public wxAppConsole
+{
+public:
+  virtual bool OnInit();
+  virtual int OnRun();
+  virtual void OnInitCmdLine(wxCmdLineParser& parser);
+  virtual bool OnCmdLineParsed(wxCmdLineParser& parser);
+private:
+  bool ReadInput();
+  void Send(std::string data);
+  wxSocketClient m_socket;
+  std::string m_input;
+  wxString m_file;
+  long m_port;
+  bool m_fast;
+};
+
+IMPLEMENT_APP_CONSOLE(ReplayApp)
+
+void ReplayApp::OnInitCmdLine(wxCmdLineParser& parser)
+{
+  parser.AddSwitch(wxT("h"), wxT("help"), wxT("show this help"),
+                   wxCMD_LINE_OPTION_HELP);
+  parser.AddSwitch(wxT("f"), wxT("fast"), wxT("do not wait as long as Maxima did"));
+  parser.AddOption(wxEmptyString, wxT("port"), wxT("port of wxMaxima (default 4010)"),
+                   wxCMD_LINE_VAL_NUMBER);
+  // the arguments wxMaxima passes to Maxima
+  parser.AddOption(wxT("r"), wxEmptyString, wxT("\":lisp (setup-client <port>)\""));
+  parser.AddOption(wxT("s"), wxEmptyString, wxT("<port>"), wxCMD_LINE_VAL_NUMBER);
+  parser.AddParam(wxT("transcript, WXMAXIMA_REPLAY is used without it"),
+                  wxCMD_LINE_VAL_STRING, wxCMD_LINE_PARAM_OPTIONAL);
+}
+
+bool ReplayApp::OnCmdLineParsed(wxCmdLineParser& parser)
+{
+  m_port = 4010;
+  m_fast = parser.Found(wxT("f"));
+
+  wxString lisp;
+  wxRegEx setupClient(wxT("setup-client +([0-9]+)"));
+  if (parser.Found(wxT("r"), &lisp) && setupClient.Matches(lisp))
+    setupClient.GetMatch(lisp, 1).ToLong(&m_port);
+  parser.Found(wxT("s"), &m_port);
+  parser.Found(wxT("port"), &m_port);
+
+  if (parser.GetParamCount() > 0)
+    m_file = parser.GetParam(0);
+  else if (!wxGetEnv(wxT("WXMAXIMA_REPLAY"), &m_file)) {
+    wxFprintf(stderr, wxT("wxmaxima-replay: no transcript given\n"));
+    return false;
+  }
+
+  return true;
+}
+
+bool ReplayApp::OnInit()
+{
+  wxSocketBase::Initialize();
+  return wxAppConsole::OnInit();
+}
+
+/***
+ * Wait for the next line wxMaxima sends, SendMaxima sends one line at a
+ * time.
+ */
+bool ReplayApp::ReadInput()
+{
+  char buffer[1024];
+  size_t end;
+
+  while ((end = m_input.find('\n')) == std::string::npos)
+  {
+    if (!m_socket.WaitForRead(REPLAY_INPUT_TIMEOUT))
+      return false;
+    m_socket.Read(buffer, sizeof(buffer));
+    if (m_socket.Error() || m_socket.LastCount() == 0)
+      return false;
+    m_input.append(buffer, m_socket.LastCount());
+  }
+
+  m_input.erase(0, end + 1);
+  return true;
+}
+
+void ReplayApp::Send(std::string data)
+{
+  // wxMaxima interrupts and kills the process id it reads from the first
+  // prompt, that must be us and not the recorded Maxima
+  size_t pid = data.find("pid=");
+  if (pid != std::string::npos)
+  {
+    char ownPid[32];
+    sprintf(ownPid, "%lu", (unsigned long)wxGetProcessId());
+    size_t end = data.find_first_not_of("0123456789", pid + 4);
+    data.replace(pid + 4, end == std::string::npos ? std::string::npos : end - pid - 4,
+                 ownPid);
+  }
+
+  m_socket.Write(data.data(), data.size());
+}
+
+int ReplayApp::OnRun()
+{
+  std::vector<TranscriptRecord> records;
+  if (!Transcript::Load(m_file, records)) {
+    wxFprintf(stderr, wxT("wxmaxima-replay: can not read %s\n"), m_file.c_str());
+    return 1;
+  }
+
+  wxIPV4address addr;
+  addr.LocalHost();
+  addr.Service(m_port);
+
+  m_socket.SetFlags(wxSOCKET_WAITALL);
+  if (!m_socket.Connect(addr, true)) {
+    wxFprintf(stderr, wxT("wxmaxima-replay: can not connect to port %ld\n"), m_port);
+    return 1;
+  }
+
+  wxStopWatch stopwatch;
+  long recordBase = 0, timeBase = 0;     // when the last input arrived
+  long lastOutput = 0;
+  long turnarounds = 0, turnaroundSum = 0, turnaroundMax = 0;
+  unsigned long bytes = 0, cells = 0;
+
+  for (size_t i = 0; i < records.size(); i++)
+  {
+    TranscriptRecord& record = records[i];
+
+    if (record.source == TRANSCRIPT_WXMAXIMA)
+    {
+      if (!ReadInput()) {
+        wxFprintf(stderr, wxT("wxmaxima-replay: wxMaxima did not send input %lu\n"),
+                  (unsigned long)i);
+        return 1;
+      }
+      recordBase = record.time;
+      timeBase = stopwatch.Time();
+      if (lastOutput > 0) {
+        long turnaround = timeBase - lastOutput;
+        turnarounds++;
+        turnaroundSum += turnaround;
+        turnaroundMax = MAX(turnaroundMax, turnaround);
+      }
+    }
+
+    else
+    {
+      long wait = timeBase + record.time - recordBase - stopwatch.Time();
+      if (!m_fast && wait > 0)
+        wxMilliSleep(wait);
+
+      Send(record.data);
+      lastOutput = stopwatch.Time();
+      bytes += record.data.size();
+      for (size_t pos = record.data.find("<mth>"); pos != std::string::npos;
+           pos = record.data.find("<mth>", pos + 1))
+        cells++;
+    }
+  }
+
+  double seconds = MAX(lastOutput, 1) / 1000.0;
+  wxPrintf(wxT("%lu bytes, %lu cells in %.3f s: %.0f bytes/s, %.1f cells/s\n"),
+           bytes, cells, seconds, bytes / seconds, cells / seconds);
+  if (turnarounds > 0)
+    wxPrintf(wxT("turnaround: %ld inputs, mean %ld ms, max %ld ms\n"),
+             turnarounds, turnaroundSum / turnarounds, turnaroundMax);
+  fflush(stdout);
+
+  // stay connected like Maxima until wxMaxima closes the connection
+  while (ReadInput())
+    ;
+
+  return 0;
+}
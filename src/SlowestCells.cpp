@@ -0,0 +1,135 @@
+///
+///  Copyright (C) 2004-2011 Andrej Vodopivec <andrej.vodopivec@gmail.com>
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///
+///  You should have received a copy of the GNU General Public License
+///  along with this program; if not, write to the Free Software
+///  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+///
+
+
+#include "SlowestCells.h"
+
+#include <wx/sizer.h>
+#include <algorithm>
+
+static bool SlowerThan(GroupCell *a, GroupCell *b)
+{
+  return a->GetEvaluationTime() > b->GetEvaluationTime();
+}
+
+SlowestCells::SlowestCells(wxWindow* parent, int id, MathCtrl *document) : wxPanel(parent, id)
+{
+  m_document = document;
+
+  m_cells = new wxListCtrl(this, slowest_cells_list_id, wxDefaultPosition, wxDefaultSize,
+                           wxLC_REPORT | wxLC_SINGLE_SEL);
+  m_cells->InsertColumn(0, _("Input"));
+  m_cells->InsertColumn(1, _("Total [s]"), wxLIST_FORMAT_RIGHT);
+  m_cells->InsertColumn(2, _("Maxima [s]"), wxLIST_FORMAT_RIGHT);
+  m_cells->InsertColumn(3, _("wxMaxima [s]"), wxLIST_FORMAT_RIGHT);
+
+  m_total = new wxStaticText(this, -1, wxEmptyString);
+
+  wxFlexGridSizer * box = new wxFlexGridSizer(1);
+  box->AddGrowableCol(0);
+  box->AddGrowableRow(0);
+
+  box->Add(m_cells, 0, wxEXPAND | wxALL, 0);
+  box->Add(m_total, 0, wxEXPAND | wxALL, 2);
+  box->Add(new wxButton(this, slowest_cells_refresh_id, _("Refresh")), 0, wxALL, 1);
+
+  SetSizer(box);
+  box->Fit(this);
+  box->SetSizeHints(this);
+}
+
+/***
+ * Collect the evaluated groups of the document. Groups in folded sections
+ * are not listed since they can not be shown.
+ */
+void SlowestCells::UpdateDisplay()
+{
+  m_groups.clear();
+
+  long total = 0;
+  GroupCell *tmp = dynamic_cast<GroupCell*>(m_document->GetTree());
+  while (tmp != NULL) {
+    if (tmp->GetEvaluationTime() >= 0) {
+      m_groups.push_back(tmp);
+      total += tmp->GetEvaluationTime();
+    }
+    tmp = dynamic_cast<GroupCell*>(tmp->m_next);
+  }
+
+  size_t evaluated = m_groups.size();
+  std::sort(m_groups.begin(), m_groups.end(), SlowerThan);
+  if (m_groups.size() > SLOWEST_CELLS_MAX)
+    m_groups.resize(SLOWEST_CELLS_MAX);
+
+  m_cells->Freeze();
+  m_cells->DeleteAllItems();
+
+  for (size_t i = 0; i < m_groups.size(); i++)
+  {
+    GroupCell *group = m_groups[i];
+    long time = group->GetEvaluationTime();
+    long display = group->GetDisplayTime();
+    wxString input;
+    if (group->GetEditable() != NULL)
+      input = group->GetEditable()->GetValue().BeforeFirst(wxT('\n'));
+
+    m_cells->InsertItem(i, input);
+    m_cells->SetItem(i, 1, wxString::Format(wxT("%.3f"), time / 1000.0));
+    m_cells->SetItem(i, 2, wxString::Format(wxT("%.3f"), MAX(time - display, 0) / 1000.0));
+    m_cells->SetItem(i, 3, wxString::Format(wxT("%.3f"), display / 1000.0));
+  }
+
+  m_cells->Thaw();
+
+  m_total->SetLabel(wxString::Format(_("%lu cells evaluated in %.1f s"),
+                                     (unsigned long)evaluated, total / 1000.0));
+}
+
+void SlowestCells::OnActivated(wxListEvent &ev)
+{
+  long row = ev.GetIndex();
+  if (row < 0 || row >= (long)m_groups.size())
+    return;
+
+  // the group may have been deleted since the list was filled
+  GroupCell *group = m_groups[row];
+  MathCell *tmp = m_document->GetTree();
+  while (tmp != NULL && tmp != group)
+    tmp = tmp->m_next;
+
+  if (tmp == NULL) {
+    UpdateDisplay();
+    return;
+  }
+
+  m_document->SetSelection(group);
+  m_document->ScrollToCell(group);
+  m_document->Refresh();
+  m_document->SetFocus();
+}
+
+void SlowestCells::OnRefresh(wxCommandEvent &ev)
+{
+  UpdateDisplay();
+}
+
+BEGIN_EVENT_TABLE(SlowestCells, wxPanel)
+  EVT_LIST_ITEM_ACTIVATED(slowest_cells_list_id, SlowestCells::OnActivated)
+  EVT_BUTTON(slowest_cells_refresh_id, SlowestCells::OnRefresh)
+END_EVENT_TABLE()
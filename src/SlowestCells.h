@@ -0,0 +1,56 @@
+///
+///  Copyright (C) 2004-2011 Andrej Vodopivec <andrej.vodopivec@gmail.com>
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///
+///  You should have received a copy of the GNU General Public License
+///  along with this program; if not, write to the Free Software
+///  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+///
+
+
+#include <wx/wx.h>
+#include <wx/listctrl.h>
+#include <vector>
+
+#ifndef SLOWESTCELLS_H
+#define SLOWESTCELLS_H
+
+#include "MathCtrl.h"
+
+#define SLOWEST_CELLS_MAX 100
+
+enum {
+  slowest_cells_list_id,
+  slowest_cells_refresh_id
+};
+
+/***
+ * The Slowest Cells pane lists the evaluated code cells of the document
+ * by their evaluation time. Activating an entry shows its cell.
+ */
+class SlowestCells : public wxPanel
+{
+public:
+  SlowestCells(wxWindow* parent, int id, MathCtrl *document);
+  void UpdateDisplay();
+  void OnActivated(wxListEvent &ev);
+  void OnRefresh(wxCommandEvent &ev);
+private:
+  MathCtrl *m_document;
+  wxListCtrl *m_cells;
+  wxStaticText *m_total;
+  std::vector<GroupCell*> m_groups; // the groups of the rows
+  DECLARE_EVENT_TABLE()
+};
+
+#endif
@@ -21,6 +21,7 @@
 #define _TEXTCELL_H_
 
 #include "MathCell.h"
+#include "TextToken.h"
 
 class TextCell : public MathCell
 {
@@ -40,22 +41,12 @@ public:
 	wxString ToXML(bool all);	// new!
   wxString GetDiffPart();
   bool IsOperator();
-  wxString GetValue() { return m_text; }
-  wxString GetGreekStringTeX();
-  wxString GetSymbolTeX();
-#if wxUSE_UNICODE
-  wxString GetGreekStringUnicode();
-  wxString GetSymbolUnicode(bool keepPercent);
-#elif defined __WXMSW__
-  wxString GetGreekStringSymbol();
-  wxString GetSymbolSymbol(bool keepPercent);
-#endif
+  wxString GetValue() { return m_token->GetText(); }
   bool IsShortNum();
 protected:
   void SetAltText(CellParser& parser);
-  wxString m_text;
-  wxString m_altText, m_altJsText;
-  wxString m_fontname, m_texFontname;
+  TextToken *m_token;
+  const TextTokenVariant *m_variant;
   bool m_alt, m_altJs;
   int m_realCenter;
   int m_fontSize;
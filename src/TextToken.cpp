@@ -0,0 +1,349 @@
+///
+///  Copyright (C) 2004-2011 Andrej Vodopivec <andrej.vodopivec@gmail.com>
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///
+///  You should have received a copy of the GNU General Public License
+///  along with this program; if not, write to the Free Software
+///  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+///
+
+#include <wx/hashmap.h>
+
+#include "TextToken.h"
+
+/***
+ * Greek letters and symbols known to all display back ends. Every lookup
+ * in this file reads these two tables, so a new letter or symbol only
+ * needs to be added here.
+ *
+ *  unicode - the character used in Unicode builds
+ *  tex     - the glyph in the jsMath TeX fonts (NULL if there is none)
+ *  symbol  - the glyph in the Windows Symbol font (NULL if there is none)
+ */
+struct GreekLetter
+{
+  const wxChar *name;
+  const wchar_t *unicode;
+  const wxChar *tex;
+  const wxChar *symbol;
+  const wxChar *latex;      // used in LaTeX export, NULL means "\name"
+};
+
+struct Symbol
+{
+  const wxChar *name;
+  const wchar_t *unicode;
+  const wxChar *tex;
+  const wxChar *texFont;
+  const wxChar *symbol;
+  bool percent;             // not replaced if the user keeps the % sign
+};
+
+static const GreekLetter greekLetters[] =
+{
+  { wxT("%alpha"),   L"\x03B1", wxT("\xCB"), wxT("\x61"), NULL },
+  { wxT("%beta"),    L"\x03B2", wxT("\xCC"), wxT("\x62"), NULL },
+  { wxT("%gamma"),   L"\x03B3", wxT("\xCD"), wxT("\x67"), NULL },
+  { wxT("%delta"),   L"\x03B4", wxT("\xCE"), wxT("\x64"), NULL },
+  { wxT("%epsilon"), L"\x03B5", wxT("\xCF"), wxT("\x65"), NULL },
+  { wxT("%zeta"),    L"\x03B6", wxT("\xB0"), wxT("\x7A"), NULL },
+  { wxT("%eta"),     L"\x03B7", wxT("\xD1"), wxT("\x68"), NULL },
+  { wxT("%theta"),   L"\x03B8", wxT("\xD2"), wxT("\x71"), NULL },
+  { wxT("%iota"),    L"\x03B9", wxT("\xD3"), wxT("\x69"), NULL },
+  { wxT("%kappa"),   L"\x03BA", wxT("\xD4"), wxT("\x6B"), NULL },
+  { wxT("%lambda"),  L"\x03BB", wxT("\xD5"), wxT("\x6C"), NULL },
+  { wxT("%mu"),      L"\x03BC", wxT("\xD6"), wxT("\x6D"), NULL },
+  { wxT("%nu"),      L"\x03BD", wxT("\xB7"), wxT("\x6E"), NULL },
+  { wxT("%xi"),      L"\x03BE", wxT("\xD8"), wxT("\x78"), NULL },
+  { wxT("%omicron"), L"\x03BF", wxT("o"),    wxT("\x6F"), NULL },
+  { wxT("%pi"),      L"\x03C0", wxT("\xD9"), wxT("\x70"), NULL },
+  { wxT("%rho"),     L"\x03C1", wxT("\xDA"), wxT("\x72"), NULL },
+  { wxT("%sigma"),   L"\x03C3", wxT("\xDB"), wxT("\x73"), NULL },
+  { wxT("%tau"),     L"\x03C4", wxT("\xDC"), wxT("\x74"), NULL },
+  { wxT("%upsilon"), L"\x03C5", wxT("\xB5"), wxT("\x75"), NULL },
+  { wxT("%phi"),     L"\x03C6", wxT("\x27"), wxT("\x66"), NULL },
+  { wxT("%chi"),     L"\x03C7", wxT("\xDF"), wxT("\x63"), NULL },
+  { wxT("%psi"),     L"\x03C8", wxT("\xEF"), wxT("\x79"), NULL },
+  { wxT("%omega"),   L"\x03C9", wxT("\x21"), wxT("\x77"), NULL },
+  { wxT("%Alpha"),   L"\x0391", wxT("A"),    wxT("\x41"), wxT("A") },
+  { wxT("%Beta"),    L"\x0392", wxT("B"),    wxT("\x42"), wxT("B") },
+  { wxT("%Gamma"),   L"\x0393", wxT("\xC0"), wxT("\x47"), NULL },
+  { wxT("%Delta"),   L"\x0394", wxT("\xC1"), wxT("\x44"), NULL },
+  { wxT("%Epsilon"), L"\x0395", wxT("E"),    wxT("\x45"), wxT("E") },
+  { wxT("%Zeta"),    L"\x0396", wxT("Z"),    wxT("\x5A"), wxT("Z") },
+  { wxT("%Eta"),     L"\x0397", wxT("H"),    wxT("\x48"), wxT("H") },
+  { wxT("%Theta"),   L"\x0398", wxT("\xC2"), wxT("\x51"), NULL },
+  { wxT("%Iota"),    L"\x0399", wxT("I"),    wxT("\x49"), wxT("I") },
+  { wxT("%Kappa"),   L"\x039A", wxT("K"),    wxT("\x4B"), wxT("K") },
+  { wxT("%Lambda"),  L"\x039B", wxT("\xC3"), wxT("\x4C"), NULL },
+  { wxT("%Mu"),      L"\x039C", wxT("M"),    wxT("\x4D"), wxT("M") },
+  { wxT("%Nu"),      L"\x039D", wxT("N"),    wxT("\x4E"), wxT("N") },
+  { wxT("%Xi"),      L"\x039E", wxT("\xC4"), wxT("\x58"), NULL },
+  { wxT("%Omicron"), L"\x039F", wxT("O"),    wxT("\x4F"), wxT("O") },
+  { wxT("%Pi"),      L"\x03A0", wxT("\xC5"), wxT("\x50"), NULL },
+  { wxT("%Rho"),     L"\x03A1", wxT("P"),    wxT("\x52"), wxT("P") },
+  { wxT("%Sigma"),   L"\x03A3", wxT("\xC6"), wxT("\x53"), NULL },
+  { wxT("%Tau"),     L"\x03A4", wxT("T"),    wxT("\x54"), wxT("T") },
+  { wxT("%Upsilon"), L"\x03A5", wxT("Y"),    wxT("\x55"), NULL },
+  { wxT("%Phi"),     L"\x03A6", wxT("\xC8"), wxT("\x46"), NULL },
+  { wxT("%Chi"),     L"\x03A7", wxT("X"),    wxT("\x43"), wxT("X") },
+  { wxT("%Psi"),     L"\x03A8", wxT("\xC9"), wxT("\x59"), NULL },
+  { wxT("%Omega"),   L"\x03A9", wxT("\xCA"), wxT("\x57"), NULL }
+};
+
+/// Greek names maxima displays without the % sign and a different letter
+static const wxChar *greekAliases[][2] =
+{
+  { wxT("gamma"), wxT("%Gamma") },   // the gamma function
+  { wxT("psi"),   wxT("%Psi") }
+};
+
+static const Symbol symbols[] =
+{
+  { wxT("+"),         L"+",           wxT("+"),    wxT("jsMath-cmr10"),  NULL,         false },
+  { wxT("="),         L"=",           wxT("="),    wxT("jsMath-cmr10"),  NULL,         false },
+  { wxT("inf"),       L"\x221E",      wxT("\x31"), wxT("jsMath-cmsy10"), wxT("\xA5"), false },
+  { wxT("%pi"),       L"\x03C0",      wxT("\xD9"), wxT("jsMath-cmmi10"), wxT("\x70"), false },
+  { wxT("<="),        L"\x2264",      wxT("\xD4"), wxT("jsMath-cmsy10"), wxT("\xA3"), false },
+  { wxT(">="),        L"\x2265",      wxT("\xD5"), wxT("jsMath-cmsy10"), wxT("\xB3"), false },
+  { wxT("->"),        L"\x2192",      wxT("\x21"), wxT("jsMath-cmsy10"), wxT("\xAE"), false },
+  { wxT(" and "),     L" \x22C0 ",    NULL,        NULL,                wxT("\xD9"), false },
+  { wxT(" or "),      L" \x22C1 ",    NULL,        NULL,                wxT("\xDA"), false },
+  { wxT(" xor "),     L" \x22BB ",    NULL,        NULL,                wxT("\xC5"), false },
+  { wxT(" nand "),    L" \x22BC ",    NULL,        NULL,                wxT("\xAD"), false },
+  { wxT(" nor "),     L" \x22BD ",    NULL,        NULL,                wxT("\xAF"), false },
+  { wxT(" implies "), L" \x21D2 ",    NULL,        NULL,                wxT("\xDE"), false },
+  { wxT(" equiv "),   L" \x21D4 ",    NULL,        NULL,                wxT("\xDB"), false },
+  { wxT("not"),       L"\x00AC",      NULL,        NULL,                wxT("\xD8"), false },
+  { wxT("%e"),        L"e",           NULL,        NULL,                wxT("e"),    true },
+  { wxT("%i"),        L"i",           NULL,        NULL,                wxT("i"),    true }
+};
+
+WX_DECLARE_STRING_HASH_MAP(TextToken*, TextTokenHash);
+WX_DECLARE_STRING_HASH_MAP(const GreekLetter*, GreekLetterHash);
+WX_DECLARE_STRING_HASH_MAP(const Symbol*, SymbolHash);
+
+// The intern table - only accessed from the GUI thread
+static TextTokenHash textTokens;
+
+TextToken::TextToken(const wxString& text)
+{
+  m_text = text;
+  m_refCount = 1;
+  for (int i = 0; i < TT_VARIANTS; i++)
+    m_resolved[i] = false;
+}
+
+TextToken* TextToken::Intern(const wxString& text)
+{
+  TextTokenHash::iterator it = textTokens.find(text);
+  if (it != textTokens.end())
+    return it->second->Ref();
+
+  TextToken *token = new TextToken(text);
+  textTokens[text] = token;
+  return token;
+}
+
+/***
+ * Tokens are reference counted so that long numbers and strings, which
+ * are rarely shared, don't stay in the table after their cells are gone.
+ */
+void TextToken::Release(TextToken *token)
+{
+  if (token == NULL)
+    return ;
+  if (--token->m_refCount > 0)
+    return ;
+  textTokens.erase(token->m_text);
+  delete token;
+}
+
+const TextTokenVariant& TextToken::GetVariant(int variant)
+{
+  if (!m_resolved[variant])
+  {
+    if (variant == TT_GREEK)
+      ResolveGreek(m_variants[variant]);
+    else
+      ResolveSymbol(m_variants[variant], variant == TT_SYMBOL_KEEP_PERCENT);
+    m_resolved[variant] = true;
+  }
+  return m_variants[variant];
+}
+
+/// Greek characters are defined in jsMath, Windows and Unicode
+void TextToken::ResolveGreek(TextTokenVariant& variant)
+{
+  variant.altJs = true;
+  variant.altJsText = GetGreekStringTeX(m_text);
+  variant.texFontname = wxT("jsMath-cmmi10");
+
+#if wxUSE_UNICODE
+  variant.alt = true;
+  variant.altText = GetGreekStringUnicode(m_text);
+#elif defined __WXMSW__
+  variant.alt = true;
+  variant.altText = GetGreekStringSymbol(m_text);
+  variant.fontname = wxT("Symbol");
+#endif
+}
+
+/// Check for other symbols
+void TextToken::ResolveSymbol(TextTokenVariant& variant, bool keepPercent)
+{
+  variant.altJsText = GetSymbolTeX(m_text);
+  if (variant.altJsText != wxEmptyString)
+  {
+    variant.texFontname = GetSymbolTeXFont(m_text);
+    variant.altJs = true;
+  }
+#if wxUSE_UNICODE
+  variant.altText = GetSymbolUnicode(m_text, keepPercent);
+  if (variant.altText != wxEmptyString)
+    variant.alt = true;
+#elif defined __WXMSW__
+  variant.altText = GetSymbolSymbol(m_text, keepPercent);
+  if (variant.altText != wxEmptyString)
+  {
+    variant.alt = true;
+    variant.fontname = wxT("Symbol");
+  }
+#endif
+}
+
+/***
+ * Finds the Greek letter for text. Names without the % sign are looked up
+ * as if they had one; with aliases the names from greekAliases are
+ * mapped first.
+ */
+static const GreekLetter *FindGreekLetter(const wxString& text, bool aliases)
+{
+  static GreekLetterHash letters;
+  static wxStringToStringHashMap aliasNames;
+  if (letters.empty())
+  {
+    for (size_t i = 0; i < sizeof(greekLetters) / sizeof(greekLetters[0]); i++)
+      letters[greekLetters[i].name] = &greekLetters[i];
+    for (size_t i = 0; i < sizeof(greekAliases) / sizeof(greekAliases[0]); i++)
+      aliasNames[greekAliases[i][0]] = greekAliases[i][1];
+  }
+
+  GreekLetterHash::iterator it;
+  if (aliases)
+  {
+    wxStringToStringHashMap::iterator alias = aliasNames.find(text);
+    if (alias != aliasNames.end())
+    {
+      it = letters.find(alias->second);
+      return it == letters.end() ? NULL : it->second;
+    }
+  }
+
+  if (text.StartsWith(wxT("%")))
+    it = letters.find(text);
+  else
+    it = letters.find(wxT("%") + text);
+
+  return it == letters.end() ? NULL : it->second;
+}
+
+static const Symbol *FindSymbol(const wxString& text)
+{
+  static SymbolHash table;
+  if (table.empty())
+    for (size_t i = 0; i < sizeof(symbols) / sizeof(symbols[0]); i++)
+      table[symbols[i].name] = &symbols[i];
+
+  SymbolHash::iterator it = table.find(text);
+  return it == table.end() ? NULL : it->second;
+}
+
+#if wxUSE_UNICODE
+
+wxString TextToken::GetGreekStringUnicode(const wxString& text)
+{
+  const GreekLetter *letter = FindGreekLetter(text, true);
+  if (letter == NULL)
+    return wxEmptyString;
+  return wxString(letter->unicode);
+}
+
+wxString TextToken::GetSymbolUnicode(const wxString& text, bool keepPercent)
+{
+  const Symbol *symbol = FindSymbol(text);
+  if (symbol == NULL || (symbol->percent && keepPercent))
+    return wxEmptyString;
+  return wxString(symbol->unicode);
+}
+
+#elif defined __WXMSW__
+
+wxString TextToken::GetGreekStringSymbol(const wxString& text)
+{
+  const GreekLetter *letter = FindGreekLetter(text, true);
+  if (letter == NULL)
+    return wxEmptyString;
+  return letter->symbol;
+}
+
+wxString TextToken::GetSymbolSymbol(const wxString& text, bool keepPercent)
+{
+  const Symbol *symbol = FindSymbol(text);
+  if (symbol == NULL || symbol->symbol == NULL ||
+      (symbol->percent && keepPercent))
+    return wxEmptyString;
+  return symbol->symbol;
+}
+
+#endif
+
+wxString TextToken::GetGreekStringTeX(const wxString& text)
+{
+  const GreekLetter *letter = FindGreekLetter(text, true);
+  if (letter == NULL)
+    return wxEmptyString;
+  return letter->tex;
+}
+
+wxString TextToken::GetSymbolTeX(const wxString& text)
+{
+  const Symbol *symbol = FindSymbol(text);
+  if (symbol == NULL || symbol->tex == NULL)
+    return wxEmptyString;
+  return symbol->tex;
+}
+
+wxString TextToken::GetSymbolTeXFont(const wxString& text)
+{
+  const Symbol *symbol = FindSymbol(text);
+  if (symbol == NULL || symbol->texFont == NULL)
+    return wxEmptyString;
+  return symbol->texFont;
+}
+
+/***
+ * The LaTeX export of a Greek letter. Unlike the display functions this
+ * does not map the aliases: "gamma" is exported as \gamma.
+ */
+wxString TextToken::GetGreekStringLaTeX(const wxString& text)
+{
+  wxString name(text);
+  if (!name.StartsWith(wxT("%")))
+    name = wxT("%") + name;
+
+  const GreekLetter *letter = FindGreekLetter(name, false);
+  if (letter != NULL && letter->latex != NULL)
+    return letter->latex;
+  return wxT("\\") + name.Mid(1);
+}
@@ -0,0 +1,80 @@
+///
+///  Copyright (C) 2004-2011 Andrej Vodopivec <andrej.vodopivec@gmail.com>
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///
+///  You should have received a copy of the GNU General Public License
+///  along with this program; if not, write to the Free Software
+///  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+///
+
+#ifndef _TEXTTOKEN_H_
+#define _TEXTTOKEN_H_
+
+#include <wx/wx.h>
+
+enum
+{
+  TT_GREEK,
+  TT_SYMBOL,
+  TT_SYMBOL_KEEP_PERCENT,
+  TT_VARIANTS
+};
+
+/***
+ * One way of displaying a token: the jsMath glyph (altJs) and the
+ * Unicode or Symbol font glyph (alt).
+ */
+struct TextTokenVariant
+{
+  TextTokenVariant() : alt(false), altJs(false) { }
+  bool alt, altJs;
+  wxString altText, altJsText;
+  wxString fontname, texFontname;
+};
+
+/***
+ * TextToken holds one distinct string displayed by TextCells together
+ * with its Greek and symbol alternatives. Tokens are interned: all cells
+ * showing the same text share one TextToken, so the alternatives are
+ * computed once per token instead of once per cell and width recalculation.
+ */
+class TextToken
+{
+public:
+  static TextToken* Intern(const wxString& text);
+  static void Release(TextToken *token);
+  TextToken* Ref() { m_refCount++; return this; }
+  const wxString& GetText() { return m_text; }
+  const TextTokenVariant& GetVariant(int variant);
+  static wxString GetGreekStringTeX(const wxString& text);
+  static wxString GetSymbolTeX(const wxString& text);
+  static wxString GetSymbolTeXFont(const wxString& text);
+  static wxString GetGreekStringLaTeX(const wxString& text);
+#if wxUSE_UNICODE
+  static wxString GetGreekStringUnicode(const wxString& text);
+  static wxString GetSymbolUnicode(const wxString& text, bool keepPercent);
+#elif defined __WXMSW__
+  static wxString GetGreekStringSymbol(const wxString& text);
+  static wxString GetSymbolSymbol(const wxString& text, bool keepPercent);
+#endif
+private:
+  TextToken(const wxString& text);
+  void ResolveGreek(TextTokenVariant& variant);
+  void ResolveSymbol(TextTokenVariant& variant, bool keepPercent);
+  wxString m_text;
+  int m_refCount;
+  bool m_resolved[TT_VARIANTS];
+  TextTokenVariant m_variants[TT_VARIANTS];
+};
+
+#endif //_TEXTTOKEN_H_
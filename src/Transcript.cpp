@@ -0,0 +1,86 @@
+///
+///  Copyright (C) 2004-2011 Andrej Vodopivec <andrej.vodopivec@gmail.com>
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///
+///  You should have received a copy of the GNU General Public License
+///  along with this program; if not, write to the Free Software
+///  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+///
+
+
+#include "Transcript.h"
+
+#include <stdio.h>
+
+#define TRANSCRIPT_HEADER "wxMaxima transcript 1\n"
+
+bool Transcript::Create(wxString file)
+{
+  if (!m_file.Create(file, true))
+    return false;
+
+  m_file.Write(TRANSCRIPT_HEADER, strlen(TRANSCRIPT_HEADER));
+  m_stopwatch.Start();
+  return true;
+}
+
+void Transcript::Record(char source, const char *data, size_t length)
+{
+  if (!m_file.IsOpened())
+    return;
+
+  char header[64];
+  sprintf(header, "%ld %c %lu\n", m_stopwatch.Time(), source, (unsigned long)length);
+  m_file.Write(header, strlen(header));
+  m_file.Write(data, length);
+  m_file.Write("\n", 1);
+}
+
+bool Transcript::Load(wxString file, std::vector<TranscriptRecord>& records)
+{
+  wxFile input;
+  if (!input.Open(file))
+    return false;
+
+  wxFileOffset length = input.Length();
+  if (length <= 0)
+    return false;
+
+  std::string content((size_t)length, '\0');
+  if (input.Read(&content[0], (size_t)length) != length)
+    return false;
+
+  if (content.compare(0, strlen(TRANSCRIPT_HEADER), TRANSCRIPT_HEADER) != 0)
+    return false;
+
+  size_t position = strlen(TRANSCRIPT_HEADER);
+  while (position < content.size())
+  {
+    size_t end = content.find('\n', position);
+    if (end == std::string::npos)
+      return false;
+
+    TranscriptRecord record;
+    unsigned long size;
+    if (sscanf(content.substr(position, end - position).c_str(), "%ld %c %lu",
+               &record.time, &record.source, &size) != 3 ||
+        end + 1 + size > content.size())
+      return false;
+
+    record.data = content.substr(end + 1, size);
+    records.push_back(record);
+    position = end + 1 + size + 1;
+  }
+
+  return true;
+}
@@ -0,0 +1,61 @@
+///
+///  Copyright (C) 2004-2011 Andrej Vodopivec <andrej.vodopivec@gmail.com>
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///
+///  You should have received a copy of the GNU General Public License
+///  along with this program; if not, write to the Free Software
+///  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+///
+
+
+#ifndef _TRANSCRIPT_H_
+#define _TRANSCRIPT_H_
+
+#include <wx/wx.h>
+#include <wx/file.h>
+#include <wx/stopwatch.h>
+#include <string>
+#include <vector>
+
+// who sent the bytes of a TranscriptRecord
+#define TRANSCRIPT_MAXIMA   'M'
+#define TRANSCRIPT_WXMAXIMA 'W'
+
+struct TranscriptRecord
+{
+  long time;         // ms since the start of the recording
+  char source;
+  std::string data;
+};
+
+/***
+ * A transcript is the raw byte stream on the socket between wxMaxima and
+ * Maxima with timestamps. wxMaxima records one when the environment
+ * variable WXMAXIMA_TRANSCRIPT names a file, wxmaxima-replay plays it back.
+ *
+ * The file starts with the line "wxMaxima transcript 1", every record is
+ * a line "<time> <source> <length>" followed by length bytes and "\n".
+ */
+class Transcript
+{
+public:
+  bool Create(wxString file);
+  bool IsRecording() { return m_file.IsOpened(); }
+  void Record(char source, const char *data, size_t length);
+  static bool Load(wxString file, std::vector<TranscriptRecord>& records);
+private:
+  wxFile m_file;
+  wxStopWatch m_stopwatch;
+};
+
+#endif //_TRANSCRIPT_H_
@@ -0,0 +1,163 @@
+///
+///  Copyright (C) 2004-2011 Andrej Vodopivec <andrej.vodopivec@gmail.com>
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///
+///  You should have received a copy of the GNU General Public License
+///  along with this program; if not, write to the Free Software
+///  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+///
+
+
+#include "Utf8Decoder.h"
+
+#define UTF8_REPLACEMENT 0xFFFD
+#define UTF8_INVALID 0xFFFFFFFF
+
+/***
+ * The length of the character starting with byte c, 0 if c can't
+ * start one.
+ */
+static size_t SequenceLength(unsigned char c)
+{
+  if (c < 0x80)
+    return 1;
+  if (c >= 0xC2 && c <= 0xDF)
+    return 2;
+  if (c >= 0xE0 && c <= 0xEF)
+    return 3;
+  if (c >= 0xF0 && c <= 0xF4)
+    return 4;
+  return 0;
+}
+
+/***
+ * Decode a complete sequence of length bytes, UTF8_INVALID if it is
+ * malformed, overlong or a surrogate.
+ */
+static wxUint32 DecodeSequence(const unsigned char *s, size_t length)
+{
+  wxUint32 code;
+  switch (length)
+  {
+  case 1:
+    return s[0];
+  case 2:
+    code = s[0] & 0x1F;
+    break;
+  case 3:
+    code = s[0] & 0x0F;
+    break;
+  default:
+    code = s[0] & 0x07;
+    break;
+  }
+  for (size_t i = 1; i < length; i++)
+  {
+    if ((s[i] & 0xC0) != 0x80)
+      return UTF8_INVALID;
+    code = (code << 6) | (s[i] & 0x3F);
+  }
+  if ((length == 3 && code < 0x800) || (length == 4 && code < 0x10000) ||
+      (code >= 0xD800 && code <= 0xDFFF) || code > 0x10FFFF)
+    return UTF8_INVALID;
+  return code;
+}
+
+void Utf8Decoder::Append(wxUint32 code, wxString& output)
+{
+#if wxUSE_UNICODE
+  if (code == 0)
+    code = ' ';
+  else if (code == UTF8_INVALID)
+    code = UTF8_REPLACEMENT;
+  if (sizeof(wchar_t) == 2 && code > 0xFFFF)
+  {
+    // UTF-16 surrogate pair
+    code -= 0x10000;
+    output += wxChar(0xD800 + (code >> 10));
+    output += wxChar(0xDC00 + (code & 0x3FF));
+  }
+  else
+    output += wxChar(code);
+#else
+  output += char(code == 0 ? ' ' : code);
+#endif
+}
+
+/***
+ * Append the characters in the length bytes at data to output.
+ */
+void Utf8Decoder::Decode(const char *data, size_t length, wxString& output)
+{
+  const unsigned char *s = (const unsigned char *)data;
+  size_t i = 0;
+
+#if wxUSE_UNICODE
+  output.Alloc(output.Length() + length);
+
+  // complete the character from the last read
+  while (m_pendingLength > 0 && i < length)
+  {
+    if ((s[i] & 0xC0) != 0x80)
+    {
+      // cut short, decode the rest again
+      Append(UTF8_REPLACEMENT, output);
+      m_pendingLength = 0;
+      break;
+    }
+    m_pending[m_pendingLength++] = s[i++];
+    if (m_pendingLength == m_needed)
+    {
+      Append(DecodeSequence((const unsigned char *)m_pending, m_needed), output);
+      m_pendingLength = 0;
+    }
+  }
+
+  while (i < length)
+  {
+    // runs of ascii
+    while (i < length && s[i] < 0x80)
+      Append(s[i++], output);
+    if (i == length)
+      break;
+
+    size_t needed = SequenceLength(s[i]);
+    if (needed == 0)
+    {
+      Append(UTF8_REPLACEMENT, output);
+      i++;
+    }
+    else if (i + needed > length)
+    {
+      // the rest comes with the next read
+      m_needed = needed;
+      m_pendingLength = 0;
+      while (i < length)
+        m_pending[m_pendingLength++] = s[i++];
+    }
+    else
+    {
+      wxUint32 code = DecodeSequence(s + i, needed);
+      if (code == UTF8_INVALID)
+        i++; // resynchronize on the next byte
+      else
+        i += needed;
+      Append(code, output);
+    }
+  }
+#else
+  output.Alloc(output.Length() + length);
+  for (; i < length; i++)
+    Append(s[i], output);
+#endif
+}
@@ -0,0 +1,45 @@
+///
+///  Copyright (C) 2004-2011 Andrej Vodopivec <andrej.vodopivec@gmail.com>
+///
+///  This program is free software; you can redistribute it and/or modify
+///  it under the terms of the GNU General Public License as published by
+///  the Free Software Foundation; either version 2 of the License, or
+///  (at your option) any later version.
+///
+///  This program is distributed in the hope that it will be useful,
+///  but WITHOUT ANY WARRANTY; without even the implied warranty of
+///  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+///  GNU General Public License for more details.
+///
+///
+///  You should have received a copy of the GNU General Public License
+///  along with this program; if not, write to the Free Software
+///  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+///
+
+
+#ifndef _UTF8DECODER_H_
+#define _UTF8DECODER_H_
+
+#include <wx/wx.h>
+
+/***
+ * Utf8Decoder turns the bytes read from Maxima into characters. A
+ * character split between two reads is kept until the rest of it
+ * arrives, so the bytes may be passed in pieces of any size. Invalid
+ * bytes become U+FFFD and NULs become spaces.
+ */
+class Utf8Decoder
+{
+public:
+  Utf8Decoder() { Reset(); }
+  void Reset() { m_pendingLength = m_needed = 0; }
+  void Decode(const char *data, size_t length, wxString& output);
+private:
+  void Append(wxUint32 code, wxString& output);
+  char m_pending[4];   // start of a character split between two reads
+  size_t m_pendingLength;
+  size_t m_needed;     // bytes of that character
+};
+
+#endif //_UTF8DECODER_H_
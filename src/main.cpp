@@ -23,6 +23,7 @@
 #include <wx/intl.h>
 #include <wx/fs_zip.h>
 #include <wx/image.h>
+#include <wx/thread.h>
 
 #if defined __WXMSW__
 #include <wx/cmdline.h>
@@ -30,6 +31,8 @@
 #endif
 
 #include "wxMaxima.h"
+#include "Profiler.h"
+#include "BatchRunner.h"
 
 // On wxGTK2 we support printing only if wxWidgets is compiled with gnome_print.
 // We have to force gnome_print support to be linked in static builds of wxMaxima.
@@ -47,11 +50,17 @@ IMPLEMENT_APP(MyApp)
 bool MyApp::OnInit()
 {
   int lang = wxLANGUAGE_UNKNOWN;
+  m_exitCode = 0;
+  m_batchRunner = NULL;
 
 #if defined __WXMSW__
   wxCmdLineParser cmdLineParser(argc, argv);
   cmdLineParser.AddOption(wxT("f"), wxT("ini"), wxT("use ini file"),wxCMD_LINE_VAL_STRING);
   cmdLineParser.AddOption(wxT("o"), wxT("open"), wxT("open file"), wxCMD_LINE_VAL_STRING);
+  cmdLineParser.AddSwitch(wxT("b"), wxT("batch"), wxT("evaluate the file, save it as .wxmx and exit"));
+  cmdLineParser.AddOption(wxT("j"), wxT("jobs"), wxT("documents evaluated at once in batch mode"), wxCMD_LINE_VAL_NUMBER);
+  cmdLineParser.AddParam(wxT("more documents or directories for batch mode"), wxCMD_LINE_VAL_STRING,
+                         wxCMD_LINE_PARAM_OPTIONAL | wxCMD_LINE_PARAM_MULTIPLE);
   cmdLineParser.Parse();
   wxString ini, file;
   if (cmdLineParser.Found(wxT("f"),&ini))
@@ -112,26 +121,76 @@ bool MyApp::OnInit()
   Connect(wxID_EXIT, wxEVT_COMMAND_MENU_SELECTED, wxCommandEventHandler(MyApp::OnFileMenu));
 #endif
 
+  long jobs = wxThread::GetCPUCount();
+  wxArrayString documents;
+
 #if defined __WXMSW__
+  bool batch = cmdLineParser.Found(wxT("b"));
+  cmdLineParser.Found(wxT("j"), &jobs);
   if (cmdLineParser.Found(wxT("o"), &file))
-    NewWindow(wxString(file));
-  else
-    NewWindow();
+    documents.Add(file);
+  for (size_t i = 0; i < cmdLineParser.GetParamCount(); i++)
+    documents.Add(cmdLineParser.GetParam(i));
 #else
-  if (argc==2)
-    NewWindow(wxString(argv[1]));
-  else
-    NewWindow();
+  // wxmaxima [file]
+  // wxmaxima --batch [-j jobs] file|directory...
+  bool batch = argc > 1 && (wxString(argv[1]) == wxT("--batch") ||
+                            wxString(argv[1]) == wxT("-b"));
+  wxString file;
+  if (argc == 2 && !batch)
+    file = argv[1];
+  for (int i = 2; batch && i < argc; i++) {
+    if (wxString(argv[i]) == wxT("-j") && i + 1 < argc)
+      wxString(argv[++i]).ToLong(&jobs);
+    else
+      documents.Add(argv[i]);
+  }
 #endif
 
+  if (batch && documents.GetCount() == 1 && wxFileExists(documents[0]))
+    NewWindow(documents[0], true);
+
+  else if (batch) {
+    wxArrayString files;
+    BatchRunner::CollectFiles(documents, files);
+    if (files.GetCount() == 0) {
+      wxFprintf(stderr, wxT("wxmaxima: --batch needs .wxm or .wxmx files or directories containing them\n"));
+      return false;
+    }
+    m_batchRunner = new BatchRunner(files, jobs);
+    m_batchRunner->Start();
+  }
+
+  else
+    NewWindow(file);
+
+  Profiler::StartStallMonitor();
+
   return true;
 }
 
+int MyApp::OnRun()
+{
+  int exitCode = wxApp::OnRun();
+  return m_exitCode != 0 ? m_exitCode : exitCode;
+}
+
+int MyApp::OnExit()
+{
+  wxDELETE(m_batchRunner);
+  Profiler::StopStallMonitor();
+  return wxApp::OnExit();
+}
+
 #if defined __WXMAC__
 int window_counter = 0;
 #endif
 
-void MyApp::NewWindow(wxString file)
+/***
+ * Open a new window with file. In batch mode the window is never shown:
+ * it evaluates file and exits.
+ */
+void MyApp::NewWindow(wxString file, bool batch)
 {
   int x = 40, y = 40, h = 650, w = 950, m = 0;
   int rs = 0;
@@ -176,6 +235,13 @@ void MyApp::NewWindow(wxString file)
     frame->SetOpenFile(file);
   }
 
+  if (batch) {
+    SetTopWindow(frame);
+    frame->SetBatchMode(true);
+    frame->InitSession();
+    return;
+  }
+
 #if defined __WXMAC__
   topLevelWindows.Append(frame);
   if (topLevelWindows.GetCount()>1)
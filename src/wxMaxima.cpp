@@ -41,6 +41,8 @@
 #include "EditorCell.h"
 #include "SlideShowCell.h"
 #include "PlotFormatWiz.h"
+#include "DocumentReader.h"
+#include "Profiler.h"
 
 #include <wx/clipbrd.h>
 #include <wx/filedlg.h>
@@ -60,6 +62,15 @@
 #include <wx/wfstream.h>
 #include <wx/txtstrm.h>
 #include <wx/fs_mem.h>
+#include <wx/stdpaths.h>
+
+#if defined WXM_LOCAL_SOCKET
+ #include <sys/types.h>
+ #include <sys/socket.h>
+ #include <sys/stat.h>
+ #include <stdlib.h>
+ #include <unistd.h>
+#endif
 
 #include <wx/url.h>
 #include <wx/sstream.h>
@@ -94,7 +105,12 @@ wxMaxima::wxMaxima(wxWindow *parent, int id, const wxString title,
   m_firstPrompt = wxT("(%i1) ");
 
   m_client = NULL;
+  m_sendOffset = 0;
+  m_processReader = NULL;
   m_server = NULL;
+#if defined WXM_LOCAL_SOCKET
+  m_localServer = NULL;
+#endif
 
   wxConfig::Get()->Read(wxT("lastPath"), &m_lastPath);
   m_lastPrompt = wxEmptyString;
@@ -106,17 +122,25 @@ wxMaxima::wxMaxima(wxWindow *parent, int id, const wxString title,
 #endif
 
   m_closing = false;
+  m_batchMode = false;
+  m_batchErrors = 0;
   m_openFile = wxEmptyString;
   m_currentFile = wxEmptyString;
   m_fileSaved = true;
 
   m_variablesOK = false;
+  m_standby = NULL;
 
   m_helpFile = wxEmptyString;
 
   m_isConnected = false;
   m_isRunning = false;
 
+  // record the socket traffic for wxmaxima-replay
+  wxString transcript;
+  if (wxGetEnv(wxT("WXMAXIMA_TRANSCRIPT"), &transcript))
+    m_transcript.Create(transcript);
+
   wxFileSystem::AddHandler(new wxMemoryFSHandler); // for saving wxmx
 
   LoadRecentDocuments();
@@ -133,16 +157,11 @@ wxMaxima::wxMaxima(wxWindow *parent, int id, const wxString title,
 
   GetMenuBar()->Enable(menu_interrupt_id, false);
 
-  /// RegEx for function definitions
-  m_funRegEx.Compile(wxT("^ *([[:alnum:]%_]+) *\\(([[:alnum:]%_,[[.].] ]*)\\) *:="));
-  // RegEx for variable definitions
-  m_varRegEx.Compile(wxT("^ *([[:alnum:]%_]+) *:"));
-  // RegEx for blank statement removal
-  m_blankStatementRegEx.Compile(wxT("(^;)|((^|;)(((\\/\\*.*\\*\\/)?([[:space:]]*))+;)+)"));
 }
 
 wxMaxima::~wxMaxima()
 {
+  StopProcessReader();
   if (m_client != NULL)
     m_client->Destroy();
 
@@ -253,19 +272,31 @@ void wxMaxima::InitSession()
     m_port++;
     if (m_port > defaultPort + 50)
     {
-      wxMessageBox(_("wxMaxima could not start the server.\n\n"
-                     "Please check you have network support\n"
-                     "enabled and try again!"),
-                   _("Fatal error"),
-                   wxOK | wxICON_ERROR);
+      ShowMessage(_("wxMaxima could not start the server.\n\n"
+                    "Please check you have network support\n"
+                    "enabled and try again!"),
+                  _("Fatal error"),
+                  wxOK | wxICON_ERROR);
       break;
     }
   }
 
+#if defined WXM_LOCAL_SOCKET
+  if (server)
+    StartLocalServer();
+#endif
+
   if (!server)
     SetStatusText(_("Starting server failed"));
   else if (!StartMaxima())
     SetStatusText(_("Starting Maxima process failed"), 1);
+  else
+    return;
+
+  if (m_batchMode) {
+    wxFprintf(stderr, wxT("wxmaxima: could not start Maxima\n"));
+    BatchFinish(2);
+  }
 }
 
 void wxMaxima::FirstOutput(wxString s)
@@ -310,16 +341,24 @@ void wxMaxima::FirstOutput(wxString s)
  */
 void wxMaxima::ConsoleAppend(wxString s, int type)
 {
+  PROFILE_SCOPE("ConsoleAppend");
   m_dispReadOut = false;
   s.Replace(m_promptSuffix, wxEmptyString);
 
+  if (m_batchMode && (type == MC_TYPE_ERROR || s.Find(wxT("-- an error.")) > -1))
+  {
+    m_batchErrors++;
+    wxFprintf(stderr, wxT("%s\n"), wxString(s).Trim().c_str());
+  }
+
   wxString t(s);
   t.Trim();
   t.Trim(false);
   if (!t.Length())
     return ;
 
-  if (type != MC_TYPE_ERROR)
+  // setting the same text again still repaints the status bar
+  if (type != MC_TYPE_ERROR && GetStatusBar()->GetStatusText(1) != _("Parsing output"))
     SetStatusText(_("Parsing output"), 1);
 
   if (type == MC_TYPE_DEFAULT)
@@ -387,25 +426,78 @@ void wxMaxima::DoConsoleAppend(wxString s, int type, bool newLine,
                                bool bigSkip)
 {
   MathCell* cell;
+  double start = Profiler::Now();
 
   s.Replace(wxT("\n"), wxT(""), true);
 
+  if (type == MC_TYPE_DEFAULT && m_console->IsTextOutput(m_console->GetWorkingGroup()))
+  {
+    cell = m_MParser.ParsePlainText(s, type);
+    if (cell != NULL)
+    {
+      m_console->AppendPlainText(dynamic_cast<PlainTextCell*>(cell));
+      AddDisplayTime(start);
+      return ;
+    }
+  }
+
   cell = m_MParser.ParseLine(s, type);
 
   if (cell == NULL)
   {
-    wxMessageBox(_("There was an error in generated XML!\n\n"
-                   "Please report this as a bug."), _("Error"),
-                 wxOK | wxICON_EXCLAMATION);
+    ShowMessage(_("There was an error in generated XML!\n\n"
+                  "Please report this as a bug."), _("Error"),
+                wxOK | wxICON_EXCLAMATION);
+    if (m_batchMode)
+      BatchFinish(2);
     return ;
   }
 
   cell->SetSkip(bigSkip);
   m_console->InsertLine(cell, newLine || cell->BreakLineHere());
+
+  AddDisplayTime(start);
+}
+
+/***
+ * Append a result sent in the compact display encoding.
+ */
+void wxMaxima::DoCompactAppend(wxString s)
+{
+  double start = Profiler::Now();
+  m_dispReadOut = false;
+  SetStatusText(_("Parsing output"), 1);
+
+  bool plainText = m_console->IsTextOutput(m_console->GetWorkingGroup());
+  MathCell *cell = m_MParser.ParseCompact(s, MC_TYPE_DEFAULT, plainText);
+
+  PlainTextCell *text = plainText ? dynamic_cast<PlainTextCell*>(cell) : NULL;
+  if (text != NULL)
+  {
+    m_console->AppendPlainText(text);
+    AddDisplayTime(start);
+    return ;
+  }
+
+  if (cell == NULL)
+  {
+    ShowMessage(_("There was an error in generated output!\n\n"
+                  "Please report this as a bug."), _("Error"),
+                wxOK | wxICON_EXCLAMATION);
+    if (m_batchMode)
+      BatchFinish(2);
+    return ;
+  }
+
+  m_console->InsertLine(cell, cell->BreakLineHere());
+
+  AddDisplayTime(start);
 }
 
 void wxMaxima::DoRawConsoleAppend(wxString s, int type)
 {
+  double start = Profiler::Now();
+
   if (type == MC_TYPE_MAIN_PROMPT)
   {
     TextCell* cell = new TextCell(s);
@@ -413,6 +505,19 @@ void wxMaxima::DoRawConsoleAppend(wxString s, int type)
     m_console->InsertLine(cell, true);
   }
 
+  else if (type == MC_TYPE_DEFAULT && m_console->IsTextOutput(m_console->GetWorkingGroup()))
+  {
+    PlainTextCell *cell = new PlainTextCell;
+    cell->SetType(type);
+    wxStringTokenizer tokens(s, wxT("\n"));
+    while (tokens.HasMoreTokens())
+      cell->AppendLine(tokens.GetNextToken());
+    if (cell->GetLineCount() > 0)
+      m_console->AppendPlainText(cell);
+    else
+      delete cell;
+  }
+
   else
   {
     wxStringTokenizer tokens(s, wxT("\n"));
@@ -439,26 +544,27 @@ void wxMaxima::DoRawConsoleAppend(wxString s, int type)
     }
     m_console->InsertLine(tmp, true);
   }
+
+  AddDisplayTime(start);
 }
 
-/**
- * We need to remove any statement which would be considered empty
- * and thus cause an error. Comments within non-empty expressions seem to
- * be fine.
- *
- * What we need to remove is any statements which are any amount of whitespace
- * and any amount of comments, in any order, ended by a semicolon,
- * and nothing else.
- *
- * The most that should be left over is a single empty statement, ";".
- *
- * @param s The command string from which to remove comment expressions.
+/***
+ * Add the time since start to the time wxMaxima spent displaying the
+ * output of the working group.
  */
-void wxMaxima::StripComments(wxString& s)
+void wxMaxima::AddDisplayTime(double start)
 {
-  m_blankStatementRegEx.Replace(&s, wxT(";"));
+  GroupCell *group = m_console->GetWorkingGroup();
+  if (group != NULL)
+    group->AddDisplayTime(Profiler::Now() - start);
 }
 
+/***
+ * Send the input s to Maxima. MaximaInput reads it in one pass: it drops
+ * comments and empty statements, finds the definitions for autocompletion
+ * and the statements for the history (if history is set), and gives the
+ * command, which is queued for the socket.
+ */
 void wxMaxima::SendMaxima(wxString s, bool history)
 {
   if (!m_variablesOK) {
@@ -466,125 +572,119 @@ void wxMaxima::SendMaxima(wxString s, bool history)
     SetupVariables();
   }
 
-#if wxUSE_UNICODE
-  s.Replace(wxT("\x00B2"), wxT("^2"));
-  s.Replace(wxT("\x00B3"), wxT("^3"));
-  s.Replace(wxT("\x00BD"), wxT("(1/2)"));
-  s.Replace(wxT("\x221A"), wxT("sqrt"));
-  s.Replace(wxT("\x03C0"), wxT("%pi"));
-  s.Replace(wxT("\x2148"), wxT("%i"));
-  s.Replace(wxT("\x2147"), wxT("%e"));
-  s.Replace(wxT("\x221E"), wxT("inf"));
-  s.Replace(wxT("\x22C0"), wxT(" and "));
-  s.Replace(wxT("\x22C1"), wxT(" or "));
-  s.Replace(wxT("\x22BB"), wxT(" xor "));
-  s.Replace(wxT("\x22BC"), wxT(" nand "));
-  s.Replace(wxT("\x22BD"), wxT(" nor "));
-  s.Replace(wxT("\x21D2"), wxT(" implies "));
-  s.Replace(wxT("\x21D4"), wxT(" equiv "));
-  s.Replace(wxT("\x00AC"), wxT(" not "));
-  s.Replace(wxT("\x2212"), wxT("-"));
-#endif
-
   SetStatusText(_("Maxima is calculating"), 1);
   m_dispReadOut = false;
 
+  wxString start(s);
+  MaximaInput input(s, m_inLispMode || start.Trim(false).StartsWith(wxT(":lisp")));
+
   /// Add this command to history
   if (history)
-    AddToHistory(s);
+    AddToHistory(input.GetStatements());
 
-  s.Replace(wxT("\n"), wxT(" "));
-  s.Append(wxT("\n"));
-  StripComments(s);
+  /// Function/variable definitions for autocompletion
+  const wxArrayString& symbols = input.GetSymbols();
+  for (size_t i = 0; i < symbols.GetCount(); i++)
+    m_console->AddSymbol(symbols[i]);
+  const wxArrayString& templates = input.GetTemplates();
+  for (size_t i = 0; i < templates.GetCount(); i++)
+    m_console->AddSymbol(templates[i], true);
 
-  /// Check for function/variable definitions
-  wxStringTokenizer commands(s, wxT(";$"));
-  while (commands.HasMoreTokens())
-  {
-    wxString line = commands.GetNextToken();
-    if (m_varRegEx.Matches(line))
-      m_console->AddSymbol(m_varRegEx.GetMatch(line, 1));
-
-    if (m_funRegEx.Matches(line))
-    {
-      wxString funName = m_funRegEx.GetMatch(line, 1);
-      m_console->AddSymbol(funName);
-
-      /// Create a template from the input
-      wxString args = m_funRegEx.GetMatch(line, 2);
-      wxStringTokenizer argTokens(args, wxT(","));
-      funName << wxT("(");
-      int count = 0;
-      while (argTokens.HasMoreTokens()) {
-        if (count > 0)
-          funName << wxT(",");
-        wxString a = argTokens.GetNextToken().Trim().Trim(false);
-        if (a != wxEmptyString)
-        {
-          if (a[0]=='[')
-            funName << wxT("[<") << a.SubString(1, a.Length()-2) << wxT(">]");
-          else
-            funName << wxT("<") << a << wxT(">");
-          count++;
-        }
-      }
-      funName << wxT(")");
-      m_console->AddSymbol(funName, true);
-    }
-  }
+  s = input.GetCommand();
 
   m_console->EnableEdit(false);
 
 #if wxUSE_UNICODE
-  m_client->Write(s.utf8_str(), strlen(s.utf8_str()));
+  wxCharBuffer data = s.utf8_str();
+  SendBytes(data, strlen(data));
 #else
-  m_client->Write(s.c_str(), s.Length());
+  SendBytes(s.c_str(), s.Length());
 #endif
 }
 
-///--------------------------------------------------------------------------------
-///  Socket stuff
-///--------------------------------------------------------------------------------
-
 /***
- * Convert problematic characters in buffer into something sane,
- * so that special character codes are not encountered unexpectedly
- * (i.e. early).
+ * Queue data for Maxima and write what the socket takes now. The rest is
+ * written on wxSOCKET_OUTPUT events, so a long input doesn't block the
+ * GUI while Maxima is reading it.
  */
-void wxMaxima::SanitizeSocketBuffer(char *buffer, int length)
+void wxMaxima::SendBytes(const char *data, size_t length)
 {
-  for (int i = 0; i < length; i++)
+  m_transcript.Record(TRANSCRIPT_WXMAXIMA, data, length);
+  m_sendQueue.append(data, length);
+  FlushSendQueue();
+}
+
+void wxMaxima::FlushSendQueue()
+{
+  if (m_client == NULL)
+    return;
+
+  while (m_sendOffset < m_sendQueue.size())
   {
-    if (buffer[i] == 0)
-      buffer[i] = ' ';  // convert input null (0) to space (0x20)
+    m_client->Write(m_sendQueue.data() + m_sendOffset,
+                    m_sendQueue.size() - m_sendOffset);
+    size_t written = m_client->LastCount();
+    m_sendOffset += written;
+    if (m_client->Error() || written == 0)
+      break; // the socket is full
+  }
+
+  if (m_sendOffset == m_sendQueue.size())
+  {
+    m_sendQueue.clear();
+    m_sendOffset = 0;
+  }
+  else if (m_sendOffset > m_sendQueue.size() / 2)
+  {
+    // don't keep the written part of a long input around
+    m_sendQueue.erase(0, m_sendOffset);
+    m_sendOffset = 0;
   }
 }
 
+///--------------------------------------------------------------------------------
+///  Socket stuff
+///--------------------------------------------------------------------------------
+
 /***
  * Client event is triggered when there is something we can read from
- * the socket.
+ * the socket. Everything available is read before the output is parsed.
+ * The buffer doubles while reads fill it, up to SOCKET_MAX_SIZE, and
+ * shrinks again when they use only a small part of it.
  */
 void wxMaxima::ClientEvent(wxSocketEvent& event)
 {
-  char buffer[SOCKET_SIZE + 1];
-  int read;
+  PROFILE_SCOPE("ClientEvent");
   switch (event.GetSocketEvent())
   {
 
   case wxSOCKET_INPUT:
-    m_client->Read(buffer, SOCKET_SIZE);
-    if (!m_client->Error())
     {
-      read = m_client->LastCount();
-      buffer[read] = 0;
-
-      SanitizeSocketBuffer(buffer, read);
+      if (m_socketBuffer.empty())
+        m_socketBuffer.resize(SOCKET_SIZE);
 
-#if wxUSE_UNICODE
-      m_currentOutput += wxString(buffer, wxConvUTF8);
-#else
-      m_currentOutput += wxString(buffer, *wxConvCurrent);
-#endif
+      bool readSome = false, full = false;
+      do
+      {
+        size_t size = m_socketBuffer.size();
+        m_client->Read(&m_socketBuffer[0], size);
+        if (m_client->Error())
+          break;
+        size_t read = m_client->LastCount();
+        readSome = true;
+
+        m_transcript.Record(TRANSCRIPT_MAXIMA, &m_socketBuffer[0], read);
+        m_decoder.Decode(&m_socketBuffer[0], read, m_currentOutput);
+
+        full = (read == size);
+        if (full && size < SOCKET_MAX_SIZE)
+          m_socketBuffer.resize(2 * size);
+        else if (read < size / 8 && size > SOCKET_SIZE)
+          m_socketBuffer.resize(size / 2);
+      } while (full && m_client->IsData());
+
+      if (!readSome)
+        break;
 
       if (!m_dispReadOut && m_currentOutput != wxT("\n")) {
         SetStatusText(_("Reading Maxima output"), 1);
@@ -604,7 +704,13 @@ void wxMaxima::ClientEvent(wxSocketEvent& event)
     }
     break;
 
+  case wxSOCKET_OUTPUT:
+    FlushSendQueue();
+    break;
+
   case wxSOCKET_LOST:
+    m_sendQueue.clear();
+    m_sendOffset = 0;
     if (!m_closing)
       ConsoleAppend(wxT("\nCLIENT: Lost socket connection ...\n"
                         "Restart Maxima with 'Maxima->Restart Maxima'.\n"),
@@ -616,6 +722,8 @@ void wxMaxima::ClientEvent(wxSocketEvent& event)
     m_client->Destroy();
     m_client = NULL;
     m_isConnected = false;
+    if (m_batchMode && !m_closing)
+      BatchFinish(2);
     break;
 
   default:
@@ -623,6 +731,22 @@ void wxMaxima::ClientEvent(wxSocketEvent& event)
   }
 }
 
+/***
+ * Set up a new connection to Maxima in m_client. Reads and writes don't
+ * wait for the socket, ClientEvent is called when it has data or room for
+ * more of the queued input.
+ */
+void wxMaxima::SetupClient()
+{
+  m_decoder.Reset();
+  m_sendQueue.clear();
+  m_sendOffset = 0;
+  m_client->SetFlags(wxSOCKET_NOWAIT);
+  m_client->SetEventHandler(*this, socket_client_id);
+  m_client->SetNotify(wxSOCKET_INPUT_FLAG | wxSOCKET_OUTPUT_FLAG | wxSOCKET_LOST_FLAG);
+  m_client->Notify(true);
+}
+
 /***
  * ServerEvent is triggered when maxima connects to the socket server.
  */
@@ -633,16 +757,24 @@ void wxMaxima::ServerEvent(wxSocketEvent& event)
 
   case wxSOCKET_CONNECTION :
     {
+      // Maxima connects either to the tcp or the unix domain server
+      wxSocketServer *server = (wxSocketServer *)event.GetSocket();
       if (m_isConnected) {
-        wxSocketBase *tmp = m_server->Accept(false);
+        wxSocketBase *tmp = server->Accept(false);
         tmp->Close();
         return;
       }
       m_isConnected = true;
-      m_client = m_server->Accept(false);
-      m_client->SetEventHandler(*this, socket_client_id);
-      m_client->SetNotify(wxSOCKET_INPUT_FLAG | wxSOCKET_LOST_FLAG);
-      m_client->Notify(true);
+      m_client = server->Accept(false);
+#if defined WXM_LOCAL_SOCKET
+      if (server == m_localServer)
+      {
+        int size = LOCAL_SOCKET_BUFFER;
+        m_client->SetOption(SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+        m_client->SetOption(SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+      }
+#endif
+      SetupClient();
 #ifndef __WXMSW__
       ReadProcessOutput();
 #endif
@@ -696,77 +828,149 @@ bool wxMaxima::StartServer()
   return m_isRunning;
 }
 
+#if defined WXM_LOCAL_SOCKET
+/***
+ * Listen on a unix domain socket in a new directory in the temp
+ * directory. mkdtemp creates the directory with mode 0700 and the socket
+ * is bound with umask 077, so only the user can connect to it from the
+ * start. If this fails Maxima connects to the tcp server.
+ */
+bool wxMaxima::StartLocalServer()
+{
+  wxString dir = wxStandardPaths::Get().GetTempDir() + wxT("/wxmaxima-XXXXXX");
+  wxCharBuffer dirBuffer = dir.fn_str();
+  if (mkdtemp(dirBuffer.data()) == NULL)
+    return false;
+  m_localSocketDir = wxString(dirBuffer, *wxConvFileName);
+  m_localSocket = m_localSocketDir + wxT("/maxima.sock");
+
+  wxUNIXaddress addr;
+  addr.Filename(m_localSocket);
+
+  mode_t mask = umask(077);
+  m_localServer = new wxSocketServer(addr);
+  umask(mask);
+  if (!m_localServer->Ok())
+  {
+    delete m_localServer;
+    m_localServer = NULL;
+    unlink(m_localSocket.fn_str());
+    rmdir(m_localSocketDir.fn_str());
+    m_localSocket = m_localSocketDir = wxEmptyString;
+    return false;
+  }
+
+  m_localServer->SetEventHandler(*this, socket_server_id);
+  m_localServer->SetNotify(wxSOCKET_CONNECTION_FLAG);
+  m_localServer->Notify(true);
+
+  return true;
+}
+#endif
+
 ///--------------------------------------------------------------------------------
 ///  Maxima process stuff
 ///--------------------------------------------------------------------------------
 
-bool wxMaxima::StartMaxima()
+/***
+ * The command line which starts a Maxima connecting back to port, or to
+ * localSocket if it is given and the lisp can open it.
+ * Returns an empty string if Maxima can not be found.
+ */
+wxString wxMaxima::GetMaximaCommand(int port, wxString localSocket)
 {
-  if (m_isConnected)
-  {
-    KillMaxima();
-    //    m_client->Close();
-    m_isConnected = false;
-  }
+  wxString command = GetCommand();
 
-  m_variablesOK = false;
-  wxString command = GetCommand();;
+  if (command.Length() == 0)
+    return wxEmptyString;
 
-  if (command.Length() > 0)
-  {
 #if defined(__WXMSW__)
  #if wxCHECK_VERSION(2, 9, 0)
-    if (wxGetOsVersion() == wxOS_WINDOWS_9X)
+  if (wxGetOsVersion() == wxOS_WINDOWS_9X)
  #else
-    if (wxGetOsVersion() == wxWIN95)
+  if (wxGetOsVersion() == wxWIN95)
  #endif
-    {
-      wxString maximaPrefix = command.SubString(1, command.Length() - 3);
-      wxString sysPath;
+  {
+    wxString maximaPrefix = command.SubString(1, command.Length() - 3);
+    wxString sysPath;
 
-      wxGetEnv(wxT("path"), &sysPath);
-      maximaPrefix.Replace(wxT("\\bin\\maxima.bat"), wxEmptyString);
+    wxGetEnv(wxT("path"), &sysPath);
+    maximaPrefix.Replace(wxT("\\bin\\maxima.bat"), wxEmptyString);
 
-      wxSetEnv(wxT("maxima_prefix"), maximaPrefix);
-      wxSetEnv(wxT("path"), maximaPrefix + wxT("\\bin;") + sysPath);
+    wxSetEnv(wxT("maxima_prefix"), maximaPrefix);
+    wxSetEnv(wxT("path"), maximaPrefix + wxT("\\bin;") + sysPath);
 
-      command = maximaPrefix + wxT("\\lib\\maxima");
-      if (!wxDirExists(command))
-        return false;
+    command = maximaPrefix + wxT("\\lib\\maxima");
+    if (!wxDirExists(command))
+      return wxEmptyString;
 
-      wxArrayString files;
-      wxDir::GetAllFiles(command, &files, wxT("maxima.exe"));
-      if (files.Count() == 0)
-        return false;
-      else
-      {
-        command = files[0];
-        command.Append(wxString::Format(
-                         wxT(" -eval \"(maxima::start-client %d)\" -eval \"(run)\" -f"),
-                         m_port
-                       ));
-      }
-    }
+    wxArrayString files;
+    wxDir::GetAllFiles(command, &files, wxT("maxima.exe"));
+    if (files.Count() == 0)
+      return wxEmptyString;
     else
-      command.Append(wxString::Format(wxT(" -s %d"), m_port));
-    wxSetEnv(wxT("home"), wxGetHomeDir());
-    wxSetEnv(wxT("maxima_signals_thread"), wxT("1"));
+    {
+      command = files[0];
+      command.Append(wxString::Format(
+                       wxT(" -eval \"(maxima::start-client %d)\" -eval \"(run)\" -f"),
+                       port
+                     ));
+    }
+  }
+  else
+    command.Append(wxString::Format(wxT(" -s %d"), port));
+  wxSetEnv(wxT("home"), wxGetHomeDir());
+  wxSetEnv(wxT("maxima_signals_thread"), wxT("1"));
 #else
+  if (localSocket.Length() > 0)
+  {
+ #if defined __WXMAC__
+    wxString client = wxGetCwd() + wxT("/") + wxT(MACPREFIX) + wxT("wxclient.lisp");
+ #else
+    wxString client = wxT(PREFIX) + wxString(wxT("/share/wxMaxima/wxclient.lisp"));
+ #endif
+    wxSetEnv(wxT("WXMAXIMA_SOCKET"), localSocket);
+    command.Append(wxT(" -p \"") + client + wxT("\""));
+    command.Append(wxString::Format(wxT(" -r \":lisp (wx-setup-client %d)\""),
+                                    port));
+  }
+  else
     command.Append(wxString::Format(wxT(" -r \":lisp (setup-client %d)\""),
-                                    m_port));
+                                    port));
 #endif
 
 #if defined __WXMAC__
-    wxSetEnv(wxT("DISPLAY"), wxT(":0.0"));
+  wxSetEnv(wxT("DISPLAY"), wxT(":0.0"));
+#endif
+
+  return command;
+}
+
+bool wxMaxima::StartMaxima()
+{
+  if (m_isConnected)
+  {
+    KillMaxima();
+    //    m_client->Close();
+    m_isConnected = false;
+  }
+
+  m_variablesOK = false;
+#if defined WXM_LOCAL_SOCKET
+  wxString command = GetMaximaCommand(m_port, m_localSocket);
+#else
+  wxString command = GetMaximaCommand(m_port);
 #endif
 
+  if (command.Length() > 0)
+  {
     m_process = new wxProcess(this, maxima_process_id);
     m_process->Redirect();
     m_first = true;
     m_pid = -1;
     SetStatusText(_("Starting Maxima..."), 1);
     wxExecute(command, wxEXEC_ASYNC, m_process);
-    m_input = m_process->GetInputStream();
+    StartProcessReader();
     SetStatusText(_("Maxima started. Waiting for connection..."), 1);
   }
   else
@@ -774,6 +978,79 @@ bool wxMaxima::StartMaxima()
   return true;
 }
 
+/***
+ * Start a spare Maxima in the background, if the user wants one. It
+ * is set up like the running one and takes its place on restart.
+ */
+void wxMaxima::StartStandby()
+{
+  bool standby = false;
+  wxConfig::Get()->Read(wxT("standbyMaxima"), &standby);
+
+  if (!standby || m_batchMode || m_standby != NULL)
+    return;
+
+  m_standby = new MaximaStandby();
+  int port = m_standby->Listen(m_port + 1);
+  wxString command;
+  if (port > 0)
+    command = GetMaximaCommand(port);
+
+  if (command.Length() == 0 ||
+      !m_standby->Start(command, GetSetupCommands(), this, maxima_process_id))
+  {
+    delete m_standby;
+    m_standby = NULL;
+  }
+}
+
+/***
+ * Replace the running Maxima by the spare one. Returns false if there
+ * is no spare ready; the caller then starts a new Maxima as usual.
+ */
+bool wxMaxima::SwitchToStandby()
+{
+  if (m_standby == NULL || !m_standby->IsReady())
+    return false;
+
+  if (m_client)
+    m_client->Notify(false);
+  if (m_isConnected)
+    KillMaxima();
+  if (m_client)
+    m_client->Destroy();
+
+  wxString banner;
+  std::string pending;
+  m_standby->TakeOver(&m_client, &m_process, &m_pid, &banner, &pending);
+  delete m_standby;
+  m_standby = NULL;
+
+  SetupClient();
+  m_sendQueue = pending;
+  FlushSendQueue();
+
+  StartProcessReader();
+  m_isConnected = true;
+  m_first = false;
+  m_inLispMode = false;
+  m_closing = false;
+  m_currentOutput = wxEmptyString;
+
+  // The spare got the general setup when it started, only tell it
+  // about the document.
+  m_variablesOK = true;
+  ReadMaximaBanner(banner);
+  SetupFileVariables();
+
+  GetMenuBar()->Enable(menu_interrupt_id, m_pid > 0);
+  SetStatusText(_("Ready for user input"), 1);
+  m_console->EnableEdit(true);
+
+  StartStandby();
+  return true;
+}
+
 
 void wxMaxima::Interrupt(wxCommandEvent& event)
 {
@@ -795,8 +1072,38 @@ void wxMaxima::Interrupt(wxCommandEvent& event)
 #endif
 }
 
+/***
+ * Read the stdout and stderr of m_process in the background. They go to
+ * the Maxima Process pane.
+ */
+void wxMaxima::StartProcessReader()
+{
+  StopProcessReader();
+  m_processStdout.Clear();
+  m_processStderr.Clear();
+
+  m_processReader = new ProcessReader(m_process, &m_processStdout, &m_processStderr);
+  if (m_processReader->Create() != wxTHREAD_NO_ERROR ||
+      m_processReader->Run() != wxTHREAD_NO_ERROR)
+  {
+    delete m_processReader;
+    m_processReader = NULL;
+  }
+}
+
+void wxMaxima::StopProcessReader()
+{
+  if (m_processReader == NULL)
+    return;
+  m_processReader->Stop();
+  delete m_processReader;
+  m_processReader = NULL;
+}
+
 void wxMaxima::KillMaxima()
 {
+  // a detached process deletes its streams when it ends
+  StopProcessReader();
   m_process->Detach();
   if (m_pid < 0)
   {
@@ -811,6 +1118,14 @@ void wxMaxima::KillMaxima()
 
 void wxMaxima::OnProcessEvent(wxProcessEvent& event)
 {
+  if (m_standby != NULL && m_standby->IsProcess(event.GetPid()))
+  {
+    m_standby->ProcessTerminated();
+    delete m_standby;
+    m_standby = NULL;
+    return;
+  }
+
   if (!m_closing)
     SetStatusText(_("Maxima process terminated."), 1);
 
@@ -823,12 +1138,27 @@ void wxMaxima::OnProcessEvent(wxProcessEvent& event)
 
 void wxMaxima::CleanUp()
 {
+  if (m_standby != NULL)
+  {
+    delete m_standby;
+    m_standby = NULL;
+  }
   if (m_client)
     m_client->Notify(false);
   if (m_isConnected)
     KillMaxima();
   if (m_isRunning)
     m_server->Destroy();
+#if defined WXM_LOCAL_SOCKET
+  if (m_localServer != NULL)
+  {
+    m_localServer->Destroy();
+    m_localServer = NULL;
+    // wxFileExists is false for sockets, so wxRemoveFile can't be used
+    unlink(m_localSocket.fn_str());
+    rmdir(m_localSocketDir.fn_str());
+  }
+#endif
 }
 
 ///--------------------------------------------------------------------------------
@@ -838,13 +1168,7 @@ void wxMaxima::CleanUp()
 void wxMaxima::ReadFirstPrompt()
 {
 #if defined(__WXMSW__)
-  int start = m_currentOutput.Find(wxT("Maxima"));
-  if (start == -1)
-    start = 0;
-  FirstOutput(wxT("wxMaxima ")
-              wxT(VERSION)
-              wxT(" http://andrejv.github.io/wxmaxima/\n") +
-              m_currentOutput.SubString(start, m_currentOutput.Length() - 1));
+  ReadMaximaBanner(m_currentOutput);
 #endif // __WXMSW__
 
   int s = m_currentOutput.Find(wxT("pid=")) + 4;
@@ -863,7 +1187,11 @@ void wxMaxima::ReadFirstPrompt()
   m_currentOutput = wxEmptyString;
   m_console->EnableEdit(true);
 
-  if (m_openFile.Length())
+  StartStandby();
+
+  if (m_batchMode)
+    BatchEvaluate();
+  else if (m_openFile.Length())
   {
     OpenFile(m_openFile);
     m_openFile = wxEmptyString;
@@ -877,6 +1205,74 @@ void wxMaxima::ReadFirstPrompt()
   }
 }
 
+/***
+ * Open the batch file and evaluate all its code cells.
+ */
+void wxMaxima::BatchEvaluate()
+{
+  // in batch mode these report errors on stderr
+  bool opened;
+  if (m_openFile.Right(5) == wxT(".wxmx"))
+    opened = OpenWXMXFile(m_openFile, m_console);
+  else
+    opened = OpenWXMFile(m_openFile, m_console);
+
+  if (!opened) {
+    wxFprintf(stderr, wxT("wxmaxima: could not open %s\n"), m_openFile.c_str());
+    BatchFinish(2);
+    return;
+  }
+
+  m_console->AddEntireDocumentToEvaluationQueue();
+  if (m_console->m_evaluationQueue->Empty())
+    BatchFinish(0);
+  else
+    TryEvaluateNextInQueue();
+}
+
+/***
+ * Show message in a message box, or on stderr in batch mode, where the
+ * frame is hidden and nobody could close the box.
+ */
+void wxMaxima::ShowMessage(const wxString& message, const wxString& caption, long style)
+{
+  if (m_batchMode)
+    wxFprintf(stderr, wxT("wxmaxima: %s\n"), message.c_str());
+  else
+    wxMessageBox(message, caption, style);
+}
+
+/***
+ * Save the evaluated document next to the batch file as .wxmx and exit
+ * with exitCode: 0 if all went well, 1 on Maxima errors, 2 if the
+ * document could not be evaluated at all.
+ */
+void wxMaxima::BatchFinish(int exitCode)
+{
+  if (m_closing)
+    return;
+
+  // read by BatchRunner
+  wxPrintf(wxT("peak-memory %ld\n"), BatchRunner::PeakMemory(m_pid));
+  fflush(stdout);
+
+  if (exitCode < 2) {
+    wxFileName file(m_openFile);
+    file.SetExt(wxT("wxmx"));
+    if (!m_console->ExportToWXMX(file.GetFullPath())) {
+      wxFprintf(stderr, wxT("wxmaxima: could not save %s\n"), file.GetFullPath().c_str());
+      exitCode = 2;
+    }
+  }
+
+  wxGetApp().SetExitCode(exitCode);
+
+  m_closing = true;
+  CleanUp();
+  Destroy();
+  wxGetApp().ExitMainLoop();
+}
+
 /***
  * Checks if maxima displayed a new chunk of math
  */
@@ -898,14 +1294,37 @@ void wxMaxima::ReadMath()
     return ;
 
   wxString mth = wxT("</mth>");
+  wxString compact = wxT("<wxb ");
   end = m_currentOutput.Find(mth);
-  while (end > -1)
+  int start = m_currentOutput.Find(compact);
+  while (end > -1 || start > -1)
   {
-    wxString o = m_currentOutput.Left(end);
-    ConsoleAppend(o + mth, MC_TYPE_DEFAULT);
-    m_currentOutput = m_currentOutput.SubString(end + mth.Length(),
-                      m_currentOutput.Length());
+    if (start > -1 && (end == -1 || start < end))
+    {
+      // <wxb LENGTH>, followed by LENGTH characters of compact encoding
+      int header = m_currentOutput.find(wxT('>'), start);
+      long length;
+      size_t stop = wxString::npos;
+      if (header != wxNOT_FOUND &&
+          m_currentOutput.SubString(start + compact.Length(), header - 1).ToLong(&length))
+        stop = MathParser::SkipCompactChars(m_currentOutput, header + 1, length);
+      if (stop == wxString::npos)
+        return; // wait for the rest
+
+      if (start > 0)
+        ConsoleAppend(m_currentOutput.Left(start), MC_TYPE_DEFAULT);
+      DoCompactAppend(m_currentOutput.Mid(header + 1, stop - header - 1));
+      m_currentOutput = m_currentOutput.Mid(stop);
+    }
+    else
+    {
+      wxString o = m_currentOutput.Left(end);
+      ConsoleAppend(o + mth, MC_TYPE_DEFAULT);
+      m_currentOutput = m_currentOutput.SubString(end + mth.Length(),
+                        m_currentOutput.Length());
+    }
     end = m_currentOutput.Find(mth);
+    start = m_currentOutput.Find(compact);
   }
 }
 
@@ -951,12 +1370,24 @@ void wxMaxima::ReadPrompt()
         //m_lastPrompt = o.Mid(1,o.Length()-1);
         //m_lastPrompt.Replace(wxT(")"), wxT(":"), false);
         m_lastPrompt = o;
+        m_console->FlushOutput();
+
+        GroupCell *group = m_console->m_evaluationQueue->GetFirst();
+        if (group != NULL)
+          group->SetEvaluationTime(m_evaluationTimer.Time());
+        if (IsPaneDisplayed(menu_pane_slowest))
+          m_slowestCells->UpdateDisplay();
+
         m_console->m_evaluationQueue->RemoveFirst(); // remove it from queue
 
         if (m_console->m_evaluationQueue->Empty()) { // queue empty?
           m_console->ShowHCaret();
           m_console->SetWorkingGroup(NULL);
           m_console->Refresh();
+          if (m_batchMode) {
+            BatchFinish(m_batchErrors > 0 ? 1 : 0);
+            return;
+          }
         }
         else { // we don't have an empty queue
           m_console->Refresh();
@@ -977,6 +1408,12 @@ void wxMaxima::ReadPrompt()
       }
 
       // We have a question
+      else if (m_batchMode) {
+        // nobody is there to answer it
+        wxFprintf(stderr, wxT("wxmaxima: Maxima asked a question: %s\n"), o.c_str());
+        BatchFinish(1);
+        return;
+      }
       else {
         if (o.Find(wxT("<mth>")) > -1)
           DoConsoleAppend(o, MC_TYPE_PROMPT);
@@ -1001,45 +1438,24 @@ void wxMaxima::ReadPrompt()
 // Clear document (if clearDocument == true), then insert file
 bool wxMaxima::OpenWXMFile(wxString file, MathCtrl *document, bool clearDocument)
 {
+  PROFILE_SCOPE("OpenWXMFile");
   SetStatusText(_("Opening file"), 1);
 	wxBeginBusyCursor();
   document->Freeze();
 
   // open wxm file
-  wxTextFile inputFile(file);
-  wxArrayString *wxmLines = NULL;
-
-  if (!inputFile.Open()) {
-    wxEndBusyCursor();
-    document->Thaw();
-    wxMessageBox(_("wxMaxima encountered an error loading ") + file, _("Error"), wxOK | wxICON_EXCLAMATION);
-    SetStatusText(_("Ready for user input"), 1);
-    return false;
-  }
+  wxArrayString *wxmLines = new wxArrayString();
 
-  if (inputFile.GetFirstLine() !=
-      wxT("/* [wxMaxima batch file version 1] [ DO NOT EDIT BY HAND! ]*/"))
-  {
-    inputFile.Close();
+  if (!DocumentReader::ReadWXMFile(file, *wxmLines)) {
+    delete wxmLines;
     wxEndBusyCursor();
     document->Thaw();
-    wxMessageBox(_("wxMaxima encountered an error loading ") + file, _("Error"), wxOK | wxICON_EXCLAMATION);
+    ShowMessage(_("wxMaxima encountered an error loading ") + file, _("Error"), wxOK | wxICON_EXCLAMATION);
     SetStatusText(_("Ready for user input"), 1);
     return false;
   }
 
-  wxmLines = new wxArrayString();
-  wxString line;
-  for (line = inputFile.GetFirstLine();
-       !inputFile.Eof();
-       line = inputFile.GetNextLine()) {
-    wxmLines->Add(line);
-  }
-  wxmLines->Add(line);
-
-  inputFile.Close();
-
-  GroupCell *tree = CreateTreeFromWXMCode(wxmLines);
+  GroupCell *tree = DocumentReader::CreateTreeFromWXMCode(wxmLines);
 
   delete wxmLines;
 
@@ -1079,6 +1495,7 @@ bool wxMaxima::OpenWXMFile(wxString file, MathCtrl *document, bool clearDocument
 
 bool wxMaxima::OpenWXMXFile(wxString file, MathCtrl *document, bool clearDocument)
 {
+  PROFILE_SCOPE("OpenWXMXFile");
   SetStatusText(_("Opening file"), 1);
   wxBeginBusyCursor();
   document->Freeze();
@@ -1086,26 +1503,10 @@ bool wxMaxima::OpenWXMXFile(wxString file, MathCtrl *document, bool clearDocumen
   // open wxmx file
   wxXmlDocument xmldoc;
 
-  wxFileSystem fs;
-  wxFSFile *fsfile = fs.OpenFile(wxT("file:") + file + wxT("#zip:content.xml"));
-
-  if ((fsfile == NULL) || (!xmldoc.Load(*(fsfile->GetStream())))) {
+  if (!DocumentReader::LoadWXMXFile(file, xmldoc)) {
     wxEndBusyCursor();
     document->Thaw();
-    delete fsfile;
-    wxMessageBox(_("wxMaxima encountered an error loading ") + file, _("Error"),
-        wxOK | wxICON_EXCLAMATION);
-    SetStatusText(_("Ready for user input"), 1);
-    return false;
-  }
-
-  delete fsfile;
-
-  // start processing the XML file
-  if (xmldoc.GetRoot()->GetName() != wxT("wxMaximaDocument")) {
-    wxEndBusyCursor();
-    document->Thaw();
-    wxMessageBox(_("wxMaxima encountered an error loading ") + file, _("Error"),
+    ShowMessage(_("wxMaxima encountered an error loading ") + file, _("Error"),
         wxOK | wxICON_EXCLAMATION);
     SetStatusText(_("Ready for user input"), 1);
     return false;
@@ -1125,7 +1526,7 @@ bool wxMaxima::OpenWXMXFile(wxString file, MathCtrl *document, bool clearDocumen
     if (version_major > DOCUMENT_VERSION_MAJOR) {
       wxEndBusyCursor();
       document->Thaw();
-      wxMessageBox(_("Document ") + file +
+      ShowMessage(_("Document ") + file +
           _(" was saved using a newer version of wxMaxima. Please update your wxMaxima."),
           _("Error"), wxOK | wxICON_EXCLAMATION);
       SetStatusText(_("Ready for user input"), 1);
@@ -1133,7 +1534,7 @@ bool wxMaxima::OpenWXMXFile(wxString file, MathCtrl *document, bool clearDocumen
     }
     if (version_minor > DOCUMENT_VERSION_MINOR) {
       wxEndBusyCursor();
-      wxMessageBox(_("Document ") + file +
+      ShowMessage(_("Document ") + file +
           _(" was saved using a newer version of wxMaxima so it may not load correctly. Please update your wxMaxima."),
           _("Warning"), wxOK | wxICON_EXCLAMATION);
       wxBeginBusyCursor();
@@ -1149,7 +1550,14 @@ bool wxMaxima::OpenWXMXFile(wxString file, MathCtrl *document, bool clearDocumen
 
   wxXmlNode *xmlcells = xmldoc.GetRoot()->GetChildren();
 
-  GroupCell *tree = CreateTreeFromXMLNode(xmlcells, file);
+  bool complete;
+  GroupCell *tree = DocumentReader::CreateTreeFromXMLNode(xmlcells, file, &complete);
+  if (!complete) {
+    wxEndBusyCursor();
+    ShowMessage(_("Parts of the document will not be loaded correctly!"), _("Warning"),
+        wxOK | wxICON_WARNING);
+    wxBeginBusyCursor();
+  }
 
   // from here on code is identical for wxm and wxmx
   if (clearDocument) {
@@ -1190,207 +1598,6 @@ bool wxMaxima::OpenWXMXFile(wxString file, MathCtrl *document, bool clearDocumen
   return true;
 }
 
-GroupCell* wxMaxima::CreateTreeFromXMLNode(wxXmlNode *xmlcells, wxString wxmxfilename)
-{
-  MathParser mp(wxmxfilename);
-  MathCell *tree = NULL;
-  MathCell *last = NULL;
-
-  bool warning = true;
-
-  if (xmlcells) {
-    last = tree = mp.ParseTag(xmlcells, false); // first cell
-    while (xmlcells->GetNext()) {
-      xmlcells = xmlcells->GetNext();
-      MathCell *cell = mp.ParseTag(xmlcells, false);
-
-      if (cell != NULL)
-      {
-        last->m_next = last->m_nextToDraw = cell;
-        last->m_next->m_previous = last->m_next->m_previousToDraw = last;
-
-        last = last->m_next;
-      }
-      else if (warning)
-      {
-        wxMessageBox(_("Parts of the document will not be loaded correctly!"), _("Warning"),
-          wxOK | wxICON_WARNING);
-        warning = false;
-      }
-    }
-  }
-
-  return dynamic_cast<GroupCell*>(tree);
-}
-
-GroupCell* wxMaxima::CreateTreeFromWXMCode(wxArrayString* wxmLines)
-{
-  bool hide = false;
-  GroupCell* tree = NULL;
-  GroupCell* last = NULL;
-  GroupCell* cell = NULL;
-
-  while (wxmLines->GetCount()>0)
-  {
-    if (wxmLines->Item(0) == wxT("/* [wxMaxima: hide output   ] */"))
-      hide = true;
-
-    // Print title
-    else if (wxmLines->Item(0) == wxT("/* [wxMaxima: title   start ]"))
-    {
-      wxmLines->RemoveAt(0);
-
-      wxString line;
-      while (wxmLines->Item(0) != wxT("   [wxMaxima: title   end   ] */"))
-      {
-        if (line.Length() == 0)
-          line = wxmLines->Item(0);
-        else
-          line += wxT("\n") + wxmLines->Item(0);
-
-        wxmLines->RemoveAt(0);
-      }
-
-      cell = new GroupCell(GC_TYPE_TITLE, line);
-      if (hide) {
-        cell->Hide(true);
-        hide = false;
-      }
-    }
-
-    // Print section
-    else if (wxmLines->Item(0) == wxT("/* [wxMaxima: section start ]"))
-    {
-      wxmLines->RemoveAt(0);
-
-      wxString line;
-      while (wxmLines->Item(0) != wxT("   [wxMaxima: section end   ] */"))
-      {
-        if (line.Length() == 0)
-          line = wxmLines->Item(0);
-        else
-          line += wxT("\n") + wxmLines->Item(0);
-
-        wxmLines->RemoveAt(0);
-      }
-
-      cell = new GroupCell(GC_TYPE_SECTION, line);
-      if (hide) {
-        cell->Hide(true);
-        hide = false;
-      }
-    }
-
-    // Print section
-    else if (wxmLines->Item(0) == wxT("/* [wxMaxima: subsect start ]"))
-    {
-      wxmLines->RemoveAt(0);
-
-      wxString line;
-      while (wxmLines->Item(0) != wxT("   [wxMaxima: subsect end   ] */"))
-      {
-        if (line.Length() == 0)
-          line = wxmLines->Item(0);
-        else
-          line += wxT("\n") + wxmLines->Item(0);
-
-        wxmLines->RemoveAt(0);
-      }
-
-      cell = new GroupCell(GC_TYPE_SUBSECTION, line);
-      if (hide) {
-        cell->Hide(true);
-        hide = false;
-      }
-    }
-
-    // Print comment
-    else if (wxmLines->Item(0) == wxT("/* [wxMaxima: comment start ]"))
-    {
-      wxmLines->RemoveAt(0);
-
-      wxString line;
-      while (wxmLines->Item(0) != wxT("   [wxMaxima: comment end   ] */"))
-      {
-        if (line.Length() == 0)
-          line = wxmLines->Item(0);
-        else
-          line += wxT("\n") + wxmLines->Item(0);
-
-        wxmLines->RemoveAt(0);
-      }
-
-      cell = new GroupCell(GC_TYPE_TEXT, line);
-      if (hide) {
-        cell->Hide(true);
-        hide = false;
-      }
-    }
-
-    // Print input
-    else if (wxmLines->Item(0) == wxT("/* [wxMaxima: input   start ] */"))
-    {
-      wxmLines->RemoveAt(0);
-
-      wxString line;
-      while (wxmLines->Item(0) != wxT("/* [wxMaxima: input   end   ] */"))
-      {
-        if (line.Length() == 0)
-          line = wxmLines->Item(0);
-        else
-          line += wxT("\n") + wxmLines->Item(0);
-
-        wxmLines->RemoveAt(0);
-      }
-
-      cell = new GroupCell(GC_TYPE_CODE, line);
-      if (hide) {
-        cell->Hide(true);
-        hide = false;
-      }
-    }
-
-    else if (wxmLines->Item(0) == wxT("/* [wxMaxima: page break    ] */"))
-    {
-      wxmLines->RemoveAt(0);
-
-      cell = new GroupCell(GC_TYPE_PAGEBREAK);
-    }
-
-    else if (wxmLines->Item(0) == wxT("/* [wxMaxima: fold    start ] */"))
-    {
-      wxmLines->RemoveAt(0);
-
-      last->HideTree(CreateTreeFromWXMCode(wxmLines));
-    }
-
-    else if (wxmLines->Item(0) == wxT("/* [wxMaxima: fold    end   ] */"))
-    {
-      wxmLines->RemoveAt(0);
-
-      break;
-    }
-
-    if (cell) { // if we have created a cell in this pass
-      if (!tree)
-        tree = last = cell;
-      else {
-
-        last->m_next = last->m_nextToDraw = ((MathCell *)cell);
-        last->m_next->m_previous = last->m_next->m_previousToDraw = ((MathCell *)last);
-
-        last = (GroupCell *)last->m_next;
-
-      }
-      cell = NULL;
-    }
-
-    wxmLines->RemoveAt(0);
-  }
-
-  return tree;
-}
-
 /***
  * This works only for gcl by default - other lisps have different prompts.
  */
@@ -1398,7 +1605,12 @@ void wxMaxima::ReadLispError()
 {
   static const wxString lispError = wxT("dbl:MAXIMA>>"); // gcl
   int end = m_currentOutput.Find(lispError);
-  if (end > -1)
+  if (end > -1 && m_batchMode)
+  {
+    wxFprintf(stderr, wxT("%s\n"), m_currentOutput.Left(end).c_str());
+    BatchFinish(1);
+  }
+  else if (end > -1)
   {
     m_readingPrompt = false;
     m_inLispMode = true;
@@ -1413,10 +1625,20 @@ void wxMaxima::ReadLispError()
 #ifndef __WXMSW__
 void wxMaxima::ReadProcessOutput()
 {
-  wxString o;
-  while (m_process->IsInputAvailable())
-    o += m_input->GetC();
+  if (m_processReader != NULL)
+    m_processReader->Drain();
+
+  ReadMaximaBanner(m_processStdout.GetRecent());
 
+  SetStatusText(_("Ready for user input"), 1);
+}
+#endif
+
+/***
+ * Maxima prints its version and the version of lisp when it starts.
+ */
+void wxMaxima::ReadMaximaBanner(wxString o)
+{
   int st = o.Find(wxT("Maxima"));
   if (st == -1)
     st = 0;
@@ -1425,10 +1647,7 @@ void wxMaxima::ReadProcessOutput()
               wxT(VERSION)
               wxT(" http://andrejv.github.io/wxmaxima/\n") +
               o.SubString(st, o.Length() - 1));
-
-  SetStatusText(_("Ready for user input"), 1);
 }
-#endif
 
 /***
  * This method is called once when maxima starts. It loads wxmathml.lisp
@@ -1436,32 +1655,113 @@ void wxMaxima::ReadProcessOutput()
  */
 void wxMaxima::SetupVariables()
 {
-  SendMaxima(wxT(":lisp-quiet (setf *prompt-suffix* \"") +
-             m_promptSuffix +
-             wxT("\")"));
-  SendMaxima(wxT(":lisp-quiet (setf *prompt-prefix* \"") +
-             m_promptPrefix +
-             wxT("\")"));
-  SendMaxima(wxT(":lisp-quiet (setf $in_netmath nil)"));
-  SendMaxima(wxT(":lisp-quiet (setf $show_openplot t)"));
+  wxArrayString setup = GetSetupCommands();
+  for (size_t i = 0; i < setup.GetCount(); i++)
+    SendMaxima(setup[i]);
+
+  SetupFileVariables();
+}
+
+/***
+ * The commands which set up a new Maxima for wxMaxima, independent of
+ * the document.
+ */
+wxArrayString wxMaxima::GetSetupCommands()
+{
+  wxArrayString setup;
+
+  setup.Add(wxT(":lisp-quiet (setf *prompt-suffix* \"") +
+            m_promptSuffix +
+            wxT("\")"));
+  setup.Add(wxT(":lisp-quiet (setf *prompt-prefix* \"") +
+            m_promptPrefix +
+            wxT("\")"));
+  setup.Add(wxT(":lisp-quiet (setf $in_netmath nil)"));
+  setup.Add(wxT(":lisp-quiet (setf $show_openplot t)"));
 #if defined (__WXMSW__)
   wxString cwd = wxGetCwd();
   cwd.Replace(wxT("\\"), wxT("/"));
-  SendMaxima(wxT(":lisp-quiet ($load \"") + cwd + wxT("/data/wxmathml\")"));
+  setup.Add(GetWxmathmlLoad(cwd + wxT("/data/wxmathml")));
 #elif defined (__WXMAC__)
   wxString cwd = wxGetCwd();
   cwd = cwd + wxT("/") + wxT(MACPREFIX);
-  SendMaxima(wxT(":lisp-quiet ($load \"") + cwd + wxT("wxmathml\")"));
+  setup.Add(GetWxmathmlLoad(cwd + wxT("wxmathml")));
   // check for Gnuplot.app - use it if it exists
   wxString gnuplotbin(wxT("/Applications/Gnuplot.app/Contents/Resources/bin/gnuplot"));
   if (wxFileExists(gnuplotbin))
-    SendMaxima(wxT(":lisp-quiet (setf $gnuplot_command \"") + gnuplotbin + wxT("\")"));
+    setup.Add(wxT(":lisp-quiet (setf $gnuplot_command \"") + gnuplotbin + wxT("\")"));
 #else
   wxString prefix = wxT(PREFIX);
-  SendMaxima(wxT(":lisp-quiet ($load \"") + prefix +
-             wxT("/share/wxMaxima/wxmathml\")"));
+  setup.Add(GetWxmathmlLoad(prefix + wxT("/share/wxMaxima/wxmathml")));
 #endif
 
+  // Ask for the compact display encoding. An older wxmathml does not
+  // know it and keeps sending xml, which is read as before.
+  bool compactDisplay = false;
+  wxConfig::Get()->Read(wxT("compactDisplay"), &compactDisplay);
+  if (compactDisplay)
+    setup.Add(wxT(":lisp-quiet (if (fboundp 'wx-compact-display) (wx-compact-display t))"));
+
+  return setup;
+}
+
+/***
+ * The command which loads wxmathml. The lisp source is compiled once for
+ * each lisp and Maxima version into the user data directory, later
+ * sessions load the compiled file. Maxima loads the source if compiling
+ * fails or the versions are not known.
+ */
+wxString wxMaxima::GetWxmathmlLoad(wxString wxmathml)
+{
+  if (m_lispVersion.IsEmpty() || m_maximaVersion.IsEmpty())
+    return wxT(":lisp-quiet ($load \"") + wxmathml + wxT("\")");
+
+  wxString cacheDir = wxStandardPaths::Get().GetUserLocalDataDir() +
+    wxFileName::GetPathSeparator() + wxT("cache");
+  if (!wxDirExists(cacheDir) &&
+      !wxFileName::Mkdir(cacheDir, 0777, wxPATH_MKDIR_FULL))
+    return wxT(":lisp-quiet ($load \"") + wxmathml + wxT("\")");
+  cacheDir.Replace(wxT("\\"), wxT("/"));
+
+  // one file for each lisp and maxima version
+  wxString version = m_lispVersion + wxT("-") + m_maximaVersion;
+  wxString name = wxT("wxmathml-");
+  for (size_t i = 0; i < version.Length(); i++)
+  {
+    wxChar c = version[i];
+    if (wxIsalnum(c) || c == wxT('.') || c == wxT('-'))
+      name += c;
+    else
+      name += wxT('_');
+  }
+
+  // compile-file-pathname adds the extension of compiled files of the lisp.
+  // The file is compiled under a name of its own for each Maxima and
+  // renamed over the old one when compiling succeeded, so that Maximas
+  // starting at the same time never load a half written or failed
+  // compilation.
+  wxString base = cacheDir + wxT("/") + name;
+  return wxT(":lisp-quiet (let ((src \"") + wxmathml + wxT(".lisp\")")
+    wxT(" (fasl (compile-file-pathname \"") + base + wxT(".lisp\")))")
+    wxT(" (unless (and (probe-file fasl) (>= (file-write-date fasl) (file-write-date src)))")
+    wxT(" (let ((*standard-output* (make-broadcast-stream)) (*error-output* (make-broadcast-stream))")
+    wxT(" (*compile-verbose* nil) (*compile-print* nil)")
+    wxT(" (tmp (compile-file-pathname (concatenate 'string \"") + base +
+    wxT("-\" (princ-to-string (getpid)) \".lisp\"))))")
+    wxT(" (multiple-value-bind (out warnings-p failure-p) (ignore-errors (compile-file src :output-file tmp))")
+    wxT(" (declare (ignore warnings-p))")
+    wxT(" (unless (and out (not failure-p)")
+    wxT(" (progn (ignore-errors (delete-file fasl)) (ignore-errors (rename-file out fasl))))")
+    wxT(" (ignore-errors (delete-file tmp))))))")
+    wxT(" (if (and (probe-file fasl) (>= (file-write-date fasl) (file-write-date src)))")
+    wxT(" (load fasl) ($load src)))");
+}
+
+/***
+ * Tell Maxima where the document is.
+ */
+void wxMaxima::SetupFileVariables()
+{
   if (m_currentFile != wxEmptyString)
   {
     wxString filename(m_currentFile);
@@ -1493,10 +1793,10 @@ wxString wxMaxima::GetCommand(bool params)
     config->Read(wxT("maxima"), &maxima);
     if (!wxFileExists(maxima))
     {
-      wxMessageBox(_("wxMaxima could not find Maxima!\n\n"
-                     "Please configure wxMaxima with 'Edit->Configure'.\n"
-                     "Then start Maxima with 'Maxima->Restart Maxima'."), _("Warning"),
-                   wxOK | wxICON_EXCLAMATION);
+      ShowMessage(_("wxMaxima could not find Maxima!\n\n"
+                    "Please configure wxMaxima with 'Edit->Configure'.\n"
+                    "Then start Maxima with 'Maxima->Restart Maxima'."), _("Warning"),
+                  wxOK | wxICON_EXCLAMATION);
       SetStatusText(_("Please configure wxMaxima with 'Edit->Configure'."));
       return wxEmptyString;
     }
@@ -1710,23 +2010,19 @@ void wxMaxima::MenuCommand(wxString cmd)
 
 void wxMaxima::DumpProcessOutput()
 {
-  wxString o;
-  while (m_process->IsInputAvailable())
-  {
-    o += m_input->GetC();
-  }
-
-  wxMessageBox(o, wxT("Process output (stdout)"));
+  if (m_processReader != NULL)
+    m_processReader->Drain();
 
-  o = wxEmptyString;
-  wxInputStream *error = m_process->GetErrorStream();
-  while (m_process->IsErrorAvailable())
-  {
-    o += error->GetC();
-  }
+  wxMessageBox(m_processStdout.GetRecent(), wxT("Process output (stdout)"));
+  wxMessageBox(m_processStderr.GetRecent(), wxT("Process output (stderr)"));
 
-  wxMessageBox(o, wxT("Process output (stderr)"));
+  wxString trace = wxFileName::GetTempDir() + wxFileName::GetPathSeparator() +
+                   wxString::Format(wxT("wxmaxima-trace-%lu.json"), wxGetProcessId());
+  wxString o = Profiler::GetSummary();
+  if (Profiler::WriteTrace(trace))
+    o += wxT("\nTrace written to ") + trace;
 
+  wxMessageBox(o, wxT("Profile"));
 }
 
 ///--------------------------------------------------------------------------------
@@ -1803,7 +2099,7 @@ void wxMaxima::UpdateMenus(wxUpdateUIEvent& event)
   menubar->Enable(menu_evaluate_all, m_console->GetTree() != NULL);
   menubar->Enable(menu_save_id, !m_fileSaved);
 
-  for (int id = menu_pane_math; id<=menu_pane_stats; id++)
+  for (int id = menu_pane_math; id<=menu_pane_process; id++)
     menubar->Check(id, IsPaneDisplayed(id));
 #if defined __WXMAC__
   menubar->Check(menu_show_toolbar, GetToolBar()->IsShown());
@@ -2339,7 +2635,8 @@ void wxMaxima::MaximaMenu(wxCommandEvent& event)
     m_closing = true;
     m_console->ClearEvaluationQueue();
     m_console->ResetInputPrompts();
-    StartMaxima();
+    if (!SwitchToStandby())
+      StartMaxima();
     break;
   case menu_soft_restart:
     MenuCommand(wxT("kill(all);"));
@@ -4113,6 +4410,9 @@ void wxMaxima::PopupMenu(wxCommandEvent& event)
   case popid_merge_cells:
     m_console->MergeCells();
     break;
+  case popid_text_output:
+    m_console->SwitchTextOutput();
+    break;
   }
 }
 
@@ -4223,12 +4523,15 @@ void wxMaxima::TryEvaluateNextInQueue()
     }
 
     group->RemoveOutput();
+    group->SetEvaluationTime(-1);
+    group->ResetDisplayTime();
 
     m_console->SetWorkingGroup(group);
     group->GetPrompt()->SetValue(m_lastPrompt);
     m_console->Recalculate();
     m_console->ScrollToCell(group);
 
+    m_evaluationTimer.Start();
     SendMaxima(text, true);
   }
   else
@@ -4802,6 +5105,9 @@ BEGIN_EVENT_TABLE(wxMaxima, wxFrame)
   EVT_UPDATE_UI(menu_pane_stats, wxMaxima::UpdateMenus)
   EVT_UPDATE_UI(menu_pane_history, wxMaxima::UpdateMenus)
   EVT_UPDATE_UI(menu_pane_format, wxMaxima::UpdateMenus)
+  EVT_UPDATE_UI(menu_pane_profiler, wxMaxima::UpdateMenus)
+  EVT_UPDATE_UI(menu_pane_slowest, wxMaxima::UpdateMenus)
+  EVT_UPDATE_UI(menu_pane_process, wxMaxima::UpdateMenus)
   EVT_UPDATE_UI(menu_remove_output, wxMaxima::UpdateMenus)
 #if defined (__WXMSW__) || defined (__WXGTK20__) || defined (__WXMAC__)
   EVT_UPDATE_UI(tb_print, wxMaxima::UpdateToolBar)
@@ -4844,13 +5150,14 @@ BEGIN_EVENT_TABLE(wxMaxima, wxFrame)
   EVT_MENU(popid_divide_cell, wxMaxima::PopupMenu)
   EVT_MENU(popid_evaluate, wxMaxima::PopupMenu)
   EVT_MENU(popid_merge_cells, wxMaxima::PopupMenu)
+  EVT_MENU(popid_text_output, wxMaxima::PopupMenu)
   EVT_MENU(menu_evaluate_all_visible, wxMaxima::MaximaMenu)
   EVT_MENU(menu_evaluate_all, wxMaxima::MaximaMenu)
   EVT_IDLE(wxMaxima::OnIdle)
   EVT_MENU(menu_remove_output, wxMaxima::EditMenu)
   EVT_MENU_RANGE(menu_recent_document_0, menu_recent_document_9, wxMaxima::OnRecentDocument)
   EVT_MENU(menu_insert_image, wxMaxima::InsertMenu)
-  EVT_MENU_RANGE(menu_pane_hideall, menu_pane_stats, wxMaxima::ShowPane)
+  EVT_MENU_RANGE(menu_pane_hideall, menu_pane_process, wxMaxima::ShowPane)
   EVT_MENU(menu_show_toolbar, wxMaxima::EditMenu)
   EVT_LISTBOX_DCLICK(history_ctrl_id, wxMaxima::HistoryDClick)
   EVT_BUTTON(menu_stats_histogram, wxMaxima::StatsMenu)
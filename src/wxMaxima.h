@@ -23,14 +23,23 @@
 
 #include "wxMaximaFrame.h"
 #include "MathParser.h"
+#include "Transcript.h"
+#include "Utf8Decoder.h"
+#include "ProcessReader.h"
+#include "MaximaInput.h"
+#include "BatchRunner.h"
+#include "MaximaStandby.h"
 
 #include <wx/socket.h>
 #include <wx/config.h>
 #include <wx/process.h>
 #include <wx/fdrepdlg.h>
 #include <wx/regex.h>
+#include <wx/stopwatch.h>
 #include <wx/html/htmlwin.h>
 #include <wx/dnd.h>
+#include <vector>
+#include <string>
 
 #if defined (__WXMSW__)
  #include <wx/msw/helpchm.h>
@@ -38,7 +47,15 @@
  #include <wx/html/helpctrl.h>
 #endif
 
-#define SOCKET_SIZE 1024
+#define SOCKET_SIZE 1024            // first size of the read buffer
+#define SOCKET_MAX_SIZE (1024*1024) // it grows while reads fill it
+
+// Maxima connects through a unix domain socket where wx can listen on one,
+// the tcp port stays as fallback
+#if defined (__UNIX__) && !defined (__WXMSW__)
+ #define WXM_LOCAL_SOCKET
+ #define LOCAL_SOCKET_BUFFER 262144
+#endif
 #define DOCUMENT_VERSION_MAJOR 1
 #define DOCUMENT_VERSION_MINOR 1
 
@@ -46,8 +63,15 @@ class MyApp : public wxApp
 {
 public:
   virtual bool OnInit();
+  virtual int OnRun();
+  virtual int OnExit();
   wxLocale m_locale;
-  void NewWindow(wxString file = wxEmptyString);
+  void NewWindow(wxString file = wxEmptyString, bool batch = false);
+  void SetExitCode(int code) { m_exitCode = code; }
+private:
+  int m_exitCode;
+  BatchRunner *m_batchRunner;
+public:
 #if defined (__WXMAC__)
   wxWindowList topLevelWindows;
   void OnFileMenu(wxCommandEvent &ev);
@@ -83,8 +107,10 @@ public:
   {
     m_openFile = file;
   }
-  void StripComments(wxString& s);
+  void SetBatchMode(bool batch) { m_batchMode = batch; }
   void SendMaxima(wxString s, bool history = false);
+  // bytes sent to Maxima which the socket didn't take yet
+  size_t GetSendQueueLength() { return m_sendQueue.size() - m_sendOffset; }
   void OpenFile(wxString file,
                 wxString command = wxEmptyString); // Open a file
   bool DocumentSaved() { return m_fileSaved; }
@@ -118,14 +144,18 @@ protected:
   void OnReplace(wxFindDialogEvent& event);
   void OnReplaceAll(wxFindDialogEvent& event);
 
-  void SanitizeSocketBuffer(char *buffer, int length);  // fix early nulls
   void ServerEvent(wxSocketEvent& event);          // server event: maxima connection
   void ClientEvent(wxSocketEvent& event);          // client event: maxima input/output
+  void SetupClient();                              // a new connection in m_client
+  void SendBytes(const char *data, size_t length); // queue data for Maxima
+  void FlushSendQueue();                           // write as much as the socket takes
 
   void ConsoleAppend(wxString s, int type);        // append maxima output to console
   void DoConsoleAppend(wxString s, int type,       //
                        bool newLine = true, bool bigSkip = true);
   void DoRawConsoleAppend(wxString s, int type);   //
+  void DoCompactAppend(wxString s);                // append compact encoded result
+  void AddDisplayTime(double start);               // time output display
 
   void EditInputMenu(wxCommandEvent& event);       //
   void EvaluateEvent(wxCommandEvent& event);       //
@@ -145,7 +175,14 @@ protected:
   wxString ExtractFirstExpression(wxString entry);
   wxString GetDefaultEntry();
   bool StartServer();                              // starts the server
+#if defined WXM_LOCAL_SOCKET
+  bool StartLocalServer();                         //   and the unix domain one
+#endif
   bool StartMaxima();                              // starts maxima (uses getCommand)
+  wxString GetMaximaCommand(int port,              //   the command line for port
+                            wxString localSocket = wxEmptyString);
+  void StartStandby();                             // starts a spare maxima
+  bool SwitchToStandby();                          // restarts using the spare
   void CleanUp();                                  // shuts down server and client on exit
   void OnClose(wxCloseEvent& event);               // close wxMaxima window
   wxString GetCommand(bool params = true);         // returns the command to start maxima
@@ -160,30 +197,50 @@ protected:
 #ifndef __WXMSW__
   void ReadProcessOutput();          // reads output of maxima command
 #endif
+  void StartProcessReader();         // stdout and stderr of m_process
+  void StopProcessReader();
+
+  // batch mode: evaluate m_openFile, save it as .wxmx and exit
+  void BatchEvaluate();
+  void BatchFinish(int exitCode);
+  void ShowMessage(const wxString& message, const wxString& caption, long style);
 
   void SetupVariables();             // sets some maxima variables
+  wxArrayString GetSetupCommands();  //   the ones independent of the document
+  wxString GetWxmathmlLoad(wxString wxmathml);
+  void SetupFileVariables();         //   the ones for the document
   void KillMaxima();                 // kills the maxima process
   void ResetTitle(bool saved);
   void FirstOutput(wxString s);
+  void ReadMaximaBanner(wxString o);
 
   // loading functions
   bool OpenWXMFile(wxString file, MathCtrl *document, bool clearDocument = true);
   bool OpenWXMXFile(wxString file, MathCtrl *document, bool clearDocument = true);
-  GroupCell* CreateTreeFromXMLNode(wxXmlNode *xmlcells, wxString wxmxfilename = wxEmptyString);
-  GroupCell* CreateTreeFromWXMCode(wxArrayString *wxmLines);
   bool SaveFile(bool forceSave = false);
   int SaveDocumentP();
 
   wxSocketBase *m_client;
   wxSocketServer *m_server;
+#if defined WXM_LOCAL_SOCKET
+  wxSocketServer *m_localServer;
+  wxString m_localSocket;
+  wxString m_localSocketDir;  // private directory of m_localSocket
+#endif
   bool m_isConnected;
   bool m_isRunning;
   bool m_first;
   long m_pid;
   wxProcess *m_process;
-  wxInputStream *m_input;
+  ProcessReader *m_processReader;  // empties the pipes of m_process
   int m_port;
   wxString m_currentOutput;
+  Utf8Decoder m_decoder;            // of the bytes read from m_client
+  std::vector<char> m_socketBuffer;
+  std::string m_sendQueue;          // encoded input waiting for the socket
+  size_t m_sendOffset;              // the part of m_sendQueue already written
+  Transcript m_transcript;
+  wxStopWatch m_evaluationTimer;   // since the working group was sent
   wxString m_promptSuffix;
   wxString m_promptPrefix;
   wxString m_firstPrompt;
@@ -198,10 +255,13 @@ protected:
   bool m_supportPrinting;
 #endif
   bool m_closing;
+  bool m_batchMode;
+  long m_batchErrors;               // Maxima errors seen in batch mode
   wxString m_openFile;
   wxString m_currentFile;
   bool m_fileSaved;
   bool m_variablesOK;
+  MaximaStandby *m_standby;
   wxString m_helpFile;
   wxString m_maximaVersion;
   wxString m_lispVersion;
@@ -212,9 +272,6 @@ protected:
 #endif
   wxFindReplaceDialog *m_findDialog;
   wxFindReplaceData m_findData;
-  wxRegEx m_funRegEx;
-  wxRegEx m_varRegEx;
-  wxRegEx m_blankStatementRegEx;
 #if wxUSE_DRAG_AND_DROP
   friend class MyDropTarget;
 #endif
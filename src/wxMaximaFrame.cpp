@@ -39,6 +39,15 @@ wxMaximaFrame::wxMaximaFrame(wxWindow* parent, int id, const wxString& title,
   // history
   m_history = new History(this, -1);
 
+  // profiler
+  m_profiler = new ProfilerPane(this, -1);
+
+  // stderr of Maxima
+  m_processLog = new ProcessLogPane(this, -1, &m_processStdout, &m_processStderr);
+
+  // slowest cells
+  m_slowestCells = new SlowestCells(this, -1, m_console);
+
   m_plotSlider = NULL;
 
   SetupMenu();
@@ -119,6 +128,33 @@ void wxMaximaFrame::do_layout()
                       PaneBorder(true).
                       Right());
 
+  m_manager.AddPane(m_profiler,
+      wxAuiPaneInfo().Name(wxT("profiler")).
+                      Caption(_("Profiler")).
+                      Show(false).
+                      TopDockable(false).
+                      BottomDockable(false).
+                      PaneBorder(true).
+                      Right());
+
+  m_manager.AddPane(m_processLog,
+      wxAuiPaneInfo().Name(wxT("process")).
+                      Caption(_("Maxima Process")).
+                      Show(false).
+                      TopDockable(false).
+                      BottomDockable(false).
+                      PaneBorder(true).
+                      Right());
+
+  m_manager.AddPane(m_slowestCells,
+      wxAuiPaneInfo().Name(wxT("slowest")).
+                      Caption(_("Slowest Cells")).
+                      Show(false).
+                      TopDockable(false).
+                      BottomDockable(false).
+                      PaneBorder(true).
+                      Right());
+
   m_manager.AddPane(CreateStatPane(),
       wxAuiPaneInfo().Name(wxT("stats")).
                       Caption(_("Statistics")).
@@ -344,6 +380,9 @@ void wxMaximaFrame::SetupMenu()
   wxglade_tmp_menu_2_sub2->AppendCheckItem(menu_pane_stats, _("Statistics\tAlt-Shift-S"));
   wxglade_tmp_menu_2_sub2->AppendCheckItem(menu_pane_history, _("History\tAlt-Shift-H"));
   wxglade_tmp_menu_2_sub2->AppendCheckItem(menu_pane_format, _("Insert Cell\tAlt-Shift-C"));
+  wxglade_tmp_menu_2_sub2->AppendCheckItem(menu_pane_slowest, _("Slowest Cells"));
+  wxglade_tmp_menu_2_sub2->AppendCheckItem(menu_pane_profiler, _("Profiler"));
+  wxglade_tmp_menu_2_sub2->AppendCheckItem(menu_pane_process, _("Maxima Process"));
   wxglade_tmp_menu_2_sub2->AppendSeparator();
   wxglade_tmp_menu_2_sub2->AppendCheckItem(menu_show_toolbar, _("Toolbar\tAlt-Shift-T"));
   wxglade_tmp_menu_2->Append(wxNewId(), _("Panes"), wxglade_tmp_menu_2_sub2);
@@ -936,6 +975,15 @@ bool wxMaximaFrame::IsPaneDisplayed(int id)
     case menu_pane_format:
       displayed = m_manager.GetPane(wxT("format")).IsShown();
       break;
+    case menu_pane_profiler:
+      displayed = m_manager.GetPane(wxT("profiler")).IsShown();
+      break;
+    case menu_pane_slowest:
+      displayed = m_manager.GetPane(wxT("slowest")).IsShown();
+      break;
+    case menu_pane_process:
+      displayed = m_manager.GetPane(wxT("process")).IsShown();
+      break;
   }
 
   return displayed;
@@ -956,11 +1004,29 @@ void wxMaximaFrame::ShowPane(int id, bool show)
     case menu_pane_format:
       m_manager.GetPane(wxT("format")).Show(show);
       break;
+    case menu_pane_profiler:
+      m_manager.GetPane(wxT("profiler")).Show(show);
+      if (show)
+        m_profiler->UpdateDisplay();
+      break;
+    case menu_pane_slowest:
+      m_manager.GetPane(wxT("slowest")).Show(show);
+      if (show)
+        m_slowestCells->UpdateDisplay();
+      break;
+    case menu_pane_process:
+      m_manager.GetPane(wxT("process")).Show(show);
+      if (show)
+        m_processLog->UpdateDisplay();
+      break;
     case menu_pane_hideall:
       m_manager.GetPane(wxT("math")).Show(false);
       m_manager.GetPane(wxT("history")).Show(false);
       m_manager.GetPane(wxT("stats")).Show(false);
       m_manager.GetPane(wxT("format")).Show(false);
+      m_manager.GetPane(wxT("profiler")).Show(false);
+      m_manager.GetPane(wxT("slowest")).Show(false);
+      m_manager.GetPane(wxT("process")).Show(false);
       break;
   }
 
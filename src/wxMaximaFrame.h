@@ -32,6 +32,9 @@
 #include "MathCtrl.h"
 #include "Setup.h"
 #include "History.h"
+#include "ProfilerPane.h"
+#include "ProcessLogPane.h"
+#include "SlowestCells.h"
 
 enum {
   socket_client_id = wxID_HIGHEST,
@@ -242,6 +245,9 @@ enum {
   menu_pane_history,
   menu_pane_format,
   menu_pane_stats,
+  menu_pane_profiler,
+  menu_pane_slowest,
+  menu_pane_process,
   menu_stats_mean,
   menu_stats_median,
   menu_stats_var,
@@ -275,7 +281,7 @@ enum {
 };
 
 #define FIRST_PANE menu_pane_hideall
-#define LAST_PANE  menu_pane_stats
+#define LAST_PANE  menu_pane_process
 
 class wxMaximaFrame: public wxFrame
 {
@@ -291,7 +297,7 @@ public:
   wxString GetRecentDocument(int i) { return m_recentDocuments[i]; }
   bool IsPaneDisplayed(int id);
   void ShowPane(int id, bool hide);
-  void AddToHistory(wxString cmd) { m_history->AddToHistory(cmd); }
+  void AddToHistory(const wxArrayString& statements) { m_history->AddToHistory(statements); }
   void ShowToolBar(bool show);
 private:
   void set_properties();
@@ -310,6 +316,10 @@ protected:
 
   MathCtrl* m_console;
   History * m_history;
+  ProfilerPane * m_profiler;
+  ProcessOutput m_processStdout, m_processStderr; // of the running Maxima
+  ProcessLogPane * m_processLog;
+  SlowestCells * m_slowestCells;
   wxSlider* m_plotSlider;
   wxArrayString m_recentDocuments;
   wxMenu* m_recentDocumentsMenu;